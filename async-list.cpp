@@ -0,0 +1,154 @@
+#include "async-list.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+// Updates that cannot be applied would leave every Future waiting forever
+static void fail(const char* what) {
+    std::cerr << "AsyncList: " << what << std::endl;
+    std::abort();
+}
+
+// The applier's threadIDs must be a valid range of 'list' threadIDs
+static int checkApplyThreads(int firstThreadID, int applyThreads) {
+    if (firstThreadID < 0 || applyThreads < 1 || firstThreadID + applyThreads > MAX_THREADS) {
+        fail("applier threadIDs out of range");
+    }
+    return applyThreads;
+}
+
+AsyncList::AsyncList(MarkedList& list, int firstThreadID, int applyThreads)
+    : list(list), firstThreadID(firstThreadID), pool(checkApplyThreads(firstThreadID, applyThreads)),
+      waiters(0), stopping(false) {
+    for (ThreadBuffer& buffer : buffers) {
+        buffer.submitted = 0;
+        buffer.applied.store(0);
+    }
+    applier = std::thread(&AsyncList::applierLoop, this);
+}
+
+AsyncList::~AsyncList() {
+    {
+        std::lock_guard<std::mutex> lock(m);
+        stopping = true;
+    }
+    applierCv.notify_one();
+    applier.join();
+}
+
+MarkedList& AsyncList::get_list() {
+    return list;
+}
+
+AsyncList::Future AsyncList::submit(MarkedList::BatchOp::Type type, int val, int threadID) {
+    ThreadBuffer& buffer = buffers[threadID];
+    uint64_t seq;
+    {
+        std::lock_guard<std::mutex> lock(buffer.m);
+        seq = buffer.submitted++;
+        buffer.ops.push_back({type, val});
+    }
+    // The applier may already have applied this update, so count the
+    // unapplied ones including it rather than subtracting from 'seq'
+    if (seq + 1 - buffer.applied.load(std::memory_order_acquire) >= ASYNC_RESULT_RING) {
+        waitApplied(threadID, seq + 2 - ASYNC_RESULT_RING); // Keep the ring from wrapping
+    }
+    return Future(this, threadID, seq);
+}
+
+AsyncList::Future AsyncList::insertAsync(int val, int threadID) {
+    return submit(MarkedList::BatchOp::Type::Insert, val, threadID);
+}
+
+AsyncList::Future AsyncList::removeAsync(int val, int threadID) {
+    return submit(MarkedList::BatchOp::Type::Remove, val, threadID);
+}
+
+void AsyncList::waitApplied(int threadID, uint64_t count) {
+    ThreadBuffer& buffer = buffers[threadID];
+    if (buffer.applied.load(std::memory_order_acquire) >= count) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(m);
+    waiters++;
+    applierCv.notify_one();
+    appliedCv.wait(lock, [&] { return buffer.applied.load(std::memory_order_acquire) >= count; });
+    waiters--;
+}
+
+void AsyncList::flush(int threadID) {
+    uint64_t count;
+    {
+        std::lock_guard<std::mutex> lock(buffers[threadID].m);
+        count = buffers[threadID].submitted;
+    }
+    waitApplied(threadID, count);
+}
+
+bool AsyncList::contains(int val, int threadID) {
+    return list.contains(val, threadID);
+}
+
+bool AsyncList::Future::ready() {
+    return owner->buffers[threadID].applied.load(std::memory_order_acquire) > seq;
+}
+
+bool AsyncList::Future::get() {
+    owner->waitApplied(threadID, seq + 1);
+    return owner->buffers[threadID].results[seq % ASYNC_RESULT_RING];
+}
+
+void AsyncList::applierLoop() {
+    std::vector<MarkedList::BatchOp> ops;
+    std::vector<MarkedList::BatchOp> drained;
+    std::vector<uint8_t> results;
+    uint64_t firstSeq[MAX_THREADS];
+    size_t offset[MAX_THREADS + 1];
+    while (true) {
+        bool last;
+        {
+            std::unique_lock<std::mutex> lock(m);
+            applierCv.wait_for(lock, std::chrono::microseconds(ASYNC_BATCH_US),
+                               [&] { return stopping || waiters > 0; });
+            last = stopping;
+        }
+
+        // Concatenated per thread, so each thread's updates stay in order
+        ops.clear();
+        for (int t = 0; t < MAX_THREADS; ++t) {
+            ThreadBuffer& buffer = buffers[t];
+            {
+                std::lock_guard<std::mutex> lock(buffer.m);
+                drained.swap(buffer.ops);
+                firstSeq[t] = buffer.submitted - drained.size();
+            }
+            offset[t] = ops.size();
+            ops.insert(ops.end(), drained.begin(), drained.end());
+            drained.clear();
+        }
+        offset[MAX_THREADS] = ops.size();
+
+        if (!ops.empty()) {
+            if (!list.applyBatch(ops, results, pool, firstThreadID)) {
+                fail("applyBatch refused the batch");
+            }
+            for (int t = 0; t < MAX_THREADS; ++t) {
+                ThreadBuffer& buffer = buffers[t];
+                uint64_t seq = firstSeq[t];
+                for (size_t i = offset[t]; i < offset[t + 1]; ++i, ++seq) {
+                    buffer.results[seq % ASYNC_RESULT_RING] = results[i];
+                }
+                buffer.applied.store(seq, std::memory_order_release);
+            }
+            {
+                std::lock_guard<std::mutex> lock(m); // So no waiter misses the notification
+            }
+            appliedCv.notify_all();
+        }
+
+        if (last) {
+            return;
+        }
+    }
+}
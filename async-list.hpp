@@ -0,0 +1,87 @@
+#ifndef ASYNC_LIST_H
+#define ASYNC_LIST_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstdint>
+
+#include "concurrent-linked-list.hpp"
+#include "thread-pool.hpp"
+
+#define ASYNC_BATCH_US 200        // Longest an update waits in a buffer
+#define ASYNC_RESULT_RING 65536   // Unapplied updates a thread may have; also how long a result is kept
+
+// ------------------------------------------------------
+// Asynchronous Updates with Background Batching
+// ------------------------------------------------------
+// insertAsync and removeAsync append the update to the caller's per-thread
+// buffer and return a Future at once. An applier thread drains every
+// buffer every ASYNC_BATCH_US, or as soon as someone waits, and applies
+// the whole batch with MarkedList::applyBatch: sorted, and one traversal
+// per key range instead of one per update. A thread's updates take effect
+// in the order it submitted them.
+//
+// Results are kept in a per-thread ring, so a Future must be read before
+// its thread submits ASYNC_RESULT_RING more updates. A thread that gets
+// that far ahead of the applier waits for it.
+class AsyncList {
+public:
+    class Future {
+    public:
+        Future() : owner(nullptr), threadID(0), seq(0) {}
+
+        bool ready(); // Whether the update has been applied
+        bool get(); // Wait until it is applied; false only for a remove that found nothing
+
+    private:
+        friend class AsyncList;
+        Future(AsyncList* owner, int threadID, uint64_t seq) : owner(owner), threadID(threadID), seq(seq) {}
+
+        AsyncList* owner;
+        int threadID;
+        uint64_t seq;
+    };
+
+    // The applier uses threadIDs firstThreadID .. firstThreadID + applyThreads - 1
+    // of 'list'; producers must use others. A range outside 0 .. MAX_THREADS - 1
+    // aborts the program.
+    AsyncList(MarkedList& list, int firstThreadID, int applyThreads = 1);
+    ~AsyncList(); // Applies every submitted update, then stops the applier
+
+    Future insertAsync(int val, int threadID);
+    Future removeAsync(int val, int threadID);
+    void flush(int threadID); // Wait until every update this thread submitted is applied
+    bool contains(int val, int threadID); // Sees applied updates only; flush first to read your writes
+
+    MarkedList& get_list();
+
+private:
+    struct alignas(64) ThreadBuffer {
+        std::mutex m;
+        std::vector<MarkedList::BatchOp> ops;
+        uint64_t submitted;                // Sequence number of the next update
+        std::atomic<uint64_t> applied;     // Updates applied so far
+        uint8_t results[ASYNC_RESULT_RING]; // Indexed by sequence number
+    };
+
+    MarkedList& list;
+    int firstThreadID;
+    ThreadPool pool;
+    ThreadBuffer buffers[MAX_THREADS];
+
+    std::thread applier;
+    std::mutex m;
+    std::condition_variable applierCv; // Wakes the applier
+    std::condition_variable appliedCv; // Wakes threads waiting for results
+    int waiters;
+    bool stopping;
+
+    Future submit(MarkedList::BatchOp::Type type, int val, int threadID);
+    void waitApplied(int threadID, uint64_t count); // Until 'count' of the thread's updates are applied
+    void applierLoop();
+};
+
+#endif
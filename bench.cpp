@@ -0,0 +1,126 @@
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <cstdlib>
+
+#include "concurrent-linked-list.hpp"
+#include "blink-tree.hpp"
+
+// ----------------------------------------------------------
+// Throughput benchmark: MarkedList vs BLinkTree vs std::set
+// ----------------------------------------------------------
+// Usage: ./bench [maxKeys] [threads] [listMaxKeys]
+// For each size from 1K up to maxKeys (x10 steps, at most MAX_BENCH_KEYS),
+// insert that many random keys with all threads, then run as many lookups
+// (half hits), and print millions of operations per second. MarkedList is
+// only run up to listMaxKeys (LIST_MAX_KEYS by default) since every
+// operation walks the list. A std::set behind a
+// shared_mutex stands in for a balanced ordered set. Finally, build a
+// MarkedList from maxKeys unsorted keys with parallelBuild at 1, 2, 4, ...
+// threads and print millions of keys linked per second.
+
+#define LIST_MAX_KEYS 10000
+#define MAX_BENCH_KEYS 100000000 // Keys are drawn from [0, 2 * n), which must fit in an int
+#define MAX_LOOKUPS 1000000
+
+// A std::set behind a reader/writer lock, with the MarkedList-style API
+struct LockedSet {
+    std::set<int> keys;
+    std::shared_mutex m;
+
+    void insert(int val, int) {
+        std::unique_lock<std::shared_mutex> lock(m);
+        keys.insert(val);
+    }
+    bool contains(int val, int) {
+        std::shared_lock<std::shared_mutex> lock(m);
+        return keys.count(val) != 0;
+    }
+};
+
+template <typename F>
+double timeThreads(int numThreads, F work) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < numThreads; ++i) {
+        threads.emplace_back(work, i);
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+template <typename Set>
+void run(const char* name, long long n, int numThreads, unsigned seed) {
+    Set set;
+    long long perThread = n / numThreads;
+    double insertSecs = timeThreads(numThreads, [&](int id) {
+        std::mt19937 rng(seed + id);
+        for (long long i = 0; i < perThread; ++i) {
+            set.insert((int)(rng() % (2 * n)), id);
+        }
+    });
+
+    long long lookups = std::min<long long>(n, MAX_LOOKUPS) / numThreads;
+    std::atomic<long long> hits(0);
+    double lookupSecs = timeThreads(numThreads, [&](int id) {
+        std::mt19937 rng(seed + 1000 + id);
+        long long found = 0;
+        for (long long i = 0; i < lookups; ++i) {
+            found += set.contains((int)(rng() % (2 * n)), id);
+        }
+        hits += found;
+    });
+
+    std::cout << "  " << name << ": insert "
+              << perThread * numThreads / insertSecs / 1e6 << " Mops/s, contains "
+              << lookups * numThreads / lookupSecs / 1e6 << " Mops/s (" << hits << " hits)" << std::endl;
+}
+
+void runBuild(long long n, int maxThreads, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::vector<int> keys(n);
+    for (int& key : keys) {
+        key = (int)(rng() % (2 * n));
+    }
+    std::cout << "parallelBuild, " << n << " unsorted keys:" << std::endl;
+    for (int t = 1; t <= maxThreads; t *= 2) {
+        MarkedList list;
+        std::vector<int> input = keys;
+        auto start = std::chrono::steady_clock::now();
+        list.parallelBuild(std::move(input), t);
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "  " << t << " threads: " << n / secs / 1e6 << " Mkeys/s" << std::endl;
+    }
+}
+
+int main(int argc, char** argv) {
+    long long maxKeys = argc > 1 ? std::atoll(argv[1]) : 1000000;
+    int numThreads = argc > 2 ? std::atoi(argv[2]) : 4;
+    long long listMaxKeys = argc > 3 ? std::atoll(argv[3]) : LIST_MAX_KEYS;
+    if (maxKeys < 1 || maxKeys > MAX_BENCH_KEYS || numThreads < 1) {
+        std::cerr << "Usage: ./bench [maxKeys <= " << MAX_BENCH_KEYS << "] [threads] [listMaxKeys]" << std::endl;
+        return 1;
+    }
+    if (numThreads > MAX_THREADS) {
+        numThreads = MAX_THREADS;
+    }
+    auto seed = std::random_device{}();
+
+    for (long long n = 1000; n <= maxKeys; n *= 10) {
+        std::cout << n << " keys, " << numThreads << " threads:" << std::endl;
+        if (n <= listMaxKeys) {
+            run<MarkedList>("MarkedList", n, numThreads, seed);
+        }
+        run<BLinkTree>("BLinkTree ", n, numThreads, seed);
+        run<LockedSet>("std::set  ", n, numThreads, seed);
+    }
+    runBuild(maxKeys, numThreads, seed);
+    return 0;
+}
@@ -0,0 +1,478 @@
+#include "blink-tree.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <thread>
+
+BLinkTree::Node::Node(int level)
+    : version(0), level(level), count(0), dead(false), highKey(LLONG_MAX), right(nullptr) {}
+
+BLinkTree::InnerNode::InnerNode(int level) : Node(level) {}
+
+BLinkTree::BLinkTree() : length(0) {
+    root.store(new Node(0), std::memory_order_release);
+}
+
+BLinkTree::~BLinkTree() {
+    // The leftmost node of every level never moves, so free level by level
+    Node* levelStart = root.load(std::memory_order_relaxed);
+    while (levelStart) {
+        Node* below = levelStart->level > 0 ? static_cast<InnerNode*>(levelStart)->children[0] : nullptr;
+        Node* curr = levelStart;
+        while (curr) {
+            Node* next = curr->right;
+            if (curr->level > 0) {
+                delete static_cast<InnerNode*>(curr);
+            } else {
+                delete curr;
+            }
+            curr = next;
+        }
+        levelStart = below;
+    }
+}
+
+// Publish 'node' before re-checking the version of the node it was read from
+void BLinkTree::protect(int threadID, Node* node, int slot) {
+    AccessedPointers::store(threadID, node, slot);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+uint64_t BLinkTree::stableVersion(Node* node) {
+    uint64_t version = node->version.load(std::memory_order_acquire);
+    while (version & 1) {
+        std::this_thread::yield();
+        version = node->version.load(std::memory_order_acquire);
+    }
+    return version;
+}
+
+// Nothing read from 'node' since stableVersion() may be trusted unless this holds
+bool BLinkTree::validate(Node* node, uint64_t version) {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return node->version.load(std::memory_order_relaxed) == version;
+}
+
+void BLinkTree::lockNode(Node* node) {
+    while (true) {
+        uint64_t version = node->version.load(std::memory_order_relaxed);
+        if (!(version & 1) &&
+            node->version.compare_exchange_weak(version, version + 1, std::memory_order_acquire)) {
+            return;
+        }
+        std::this_thread::yield();
+    }
+}
+
+void BLinkTree::unlockNode(Node* node) {
+    node->version.fetch_add(1, std::memory_order_release);
+}
+
+// Latch the node that covers 'val' on this level, moving right past splits.
+// Returns nullptr, with nothing latched, if 'node' has been merged away.
+BLinkTree::Node* BLinkTree::lockAndMoveRight(Node* node, int val) {
+    lockNode(node);
+    if (node->dead) {
+        unlockNode(node);
+        return nullptr;
+    }
+    while (val >= node->highKey) {
+        Node* next = node->right; // Merging 'next' away needs the latch held on 'node'
+        lockNode(next);
+        unlockNode(node);
+        node = next;
+    }
+    return node;
+}
+
+// Counts are clamped so that a torn optimistic read stays in bounds
+int BLinkTree::lowerBound(Node* node, int val) {
+    int count = std::min(std::max(node->count, 0), BTREE_FANOUT);
+    return std::lower_bound(node->keys, node->keys + count, val) - node->keys;
+}
+
+BLinkTree::Node* BLinkTree::childFor(InnerNode* node, int val) {
+    int count = std::min(std::max(node->count, 0), BTREE_FANOUT);
+    int i = std::upper_bound(node->keys, node->keys + count, val) - node->keys;
+    return node->children[i];
+}
+
+// Find, without latching, the node on 'level' whose range held 'val'. The
+// caller latches it and moves right if it has split since. 'path' receives
+// the inner node descended through on each level above. Each node is
+// published in slot 0 or 1 before its parent or left neighbour is
+// re-validated; the result is left in slot 0.
+BLinkTree::Node* BLinkTree::descend(int val, int level, std::vector<Node*>* path, int threadID) {
+    while (true) {
+        if (path) {
+            path->clear();
+        }
+        Node* node = root.load(std::memory_order_acquire); // Former roots are never freed
+        int slot = 0;
+        bool restart = false;
+
+        while (!restart) {
+            uint64_t version = stableVersion(node);
+            if (node->dead) {
+                restart = true;
+                break;
+            }
+            if (val >= node->highKey) {
+                Node* next = node->right;
+                slot ^= 1;
+                protect(threadID, next, slot);
+                if (!validate(node, version)) {
+                    restart = true;
+                    break;
+                }
+                node = next;
+                continue;
+            }
+            if (node->level == level) {
+                if (slot != 0) {
+                    protect(threadID, node, 0);
+                }
+                return node;
+            }
+
+            Node* child = childFor(static_cast<InnerNode*>(node), val);
+            slot ^= 1;
+            protect(threadID, child, slot);
+            if (!validate(node, version)) {
+                restart = true;
+                break;
+            }
+            if (path) {
+                path->push_back(node);
+            }
+            node = child;
+        }
+    }
+}
+
+static void insertSeparator(int* keys, int& count, int i, int separator) {
+    for (int j = count; j > i; --j) {
+        keys[j] = keys[j - 1];
+    }
+    keys[i] = separator;
+    count++;
+}
+
+// 'level' is the parent's level. 'left' may already be merged away and is
+// only compared with the root.
+void BLinkTree::insertIntoParent(std::vector<Node*>& path, int level, Node* left, int separator, Node* right,
+                                 int threadID) {
+    Node* parent;
+    if (!path.empty()) {
+        parent = path.back();
+        path.pop_back();
+    } else {
+        {
+            std::lock_guard<std::mutex> lock(rootMutex);
+            if (root.load(std::memory_order_relaxed) == left) {
+                InnerNode* grown = new InnerNode(level);
+                grown->count = 1;
+                grown->keys[0] = separator;
+                grown->children[0] = left;
+                grown->children[1] = right;
+                root.store(grown, std::memory_order_release);
+                return;
+            }
+        }
+        // The root grew above 'left' after it was read; find the parent again
+        parent = descend(separator, level, &path, threadID);
+    }
+
+    // Inner nodes are never merged, so this always latches
+    InnerNode* inner = static_cast<InnerNode*>(lockAndMoveRight(parent, separator));
+
+    InnerNode* target = inner;
+    InnerNode* sibling = nullptr;
+    int pushUp = 0;
+    if (inner->count == BTREE_FANOUT) {
+        // Split: keys[mid] moves up, the keys after it go to the new sibling
+        int mid = BTREE_FANOUT / 2;
+        pushUp = inner->keys[mid];
+        sibling = new InnerNode(level);
+        sibling->count = BTREE_FANOUT - mid - 1;
+        std::copy(inner->keys + mid + 1, inner->keys + BTREE_FANOUT, sibling->keys);
+        std::copy(inner->children + mid + 1, inner->children + BTREE_FANOUT + 1, sibling->children);
+        sibling->highKey = inner->highKey;
+        sibling->right = inner->right;
+        inner->count = mid;
+        target = separator < pushUp ? inner : sibling;
+    }
+
+    int i = std::upper_bound(target->keys, target->keys + target->count, separator) - target->keys;
+    for (int j = target->count + 1; j > i + 1; --j) {
+        target->children[j] = target->children[j - 1];
+    }
+    target->children[i + 1] = right;
+    insertSeparator(target->keys, target->count, i, separator);
+
+    if (sibling) {
+        // Publish the sibling only once it is complete
+        inner->highKey = pushUp;
+        inner->right = sibling;
+    }
+    unlockNode(inner);
+
+    if (sibling) {
+        insertIntoParent(path, level + 1, inner, pushUp, sibling, threadID);
+    }
+}
+
+bool BLinkTree::insert(int val, int threadID) {
+    std::vector<Node*> path;
+    Node* leaf = nullptr;
+    while (!leaf) {
+        leaf = lockAndMoveRight(descend(val, 0, &path, threadID), val);
+    }
+    AccessedPointers::reset(threadID); // The latch keeps 'leaf' from being merged away
+
+    int i = lowerBound(leaf, val);
+    if (i < leaf->count && leaf->keys[i] == val) {
+        unlockNode(leaf);
+        return false;
+    }
+
+    if (leaf->count < BTREE_FANOUT) {
+        insertSeparator(leaf->keys, leaf->count, i, val);
+        unlockNode(leaf);
+        length.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Split: the upper half moves to a new right sibling
+    int half = BTREE_FANOUT / 2;
+    Node* sibling = new Node(0);
+    sibling->count = BTREE_FANOUT - half;
+    std::copy(leaf->keys + half, leaf->keys + BTREE_FANOUT, sibling->keys);
+    sibling->highKey = leaf->highKey;
+    sibling->right = leaf->right;
+    leaf->count = half;
+
+    int separator = sibling->keys[0];
+    Node* target = val < separator ? leaf : sibling;
+    insertSeparator(target->keys, target->count, lowerBound(target, val), val);
+
+    leaf->highKey = separator;
+    leaf->right = sibling;
+    unlockNode(leaf);
+    length.fetch_add(1, std::memory_order_relaxed);
+
+    insertIntoParent(path, 1, leaf, separator, sibling, threadID);
+    AccessedPointers::reset(threadID);
+    return true;
+}
+
+bool BLinkTree::remove(int val, int threadID) {
+    std::vector<Node*> path;
+    Node* leaf = nullptr;
+    while (!leaf) {
+        leaf = lockAndMoveRight(descend(val, 0, &path, threadID), val);
+    }
+    AccessedPointers::reset(threadID);
+
+    int i = lowerBound(leaf, val);
+    if (i == leaf->count || leaf->keys[i] != val) {
+        unlockNode(leaf);
+        return false;
+    }
+
+    for (int j = i; j < leaf->count - 1; ++j) {
+        leaf->keys[j] = leaf->keys[j + 1];
+    }
+    leaf->count--;
+    bool sparse = leaf->count < BTREE_MERGE_BELOW;
+    unlockNode(leaf);
+    length.fetch_sub(1, std::memory_order_relaxed);
+
+    if (sparse) {
+        mergeLeaf(path, val);
+    }
+    return true;
+}
+
+// Merge the leaf covering 'val' with its neighbour under the same parent
+// if both fit in half a node. Latches go parent first, then left to right,
+// the same order as every other writer. Nothing is merged when the parent
+// does not link the two leaves directly, e.g. while a split between them
+// has not been posted to the parent yet.
+void BLinkTree::mergeLeaf(std::vector<Node*>& path, int val) {
+    if (path.empty()) {
+        return; // The leaf was the root
+    }
+    InnerNode* parent = static_cast<InnerNode*>(lockAndMoveRight(path.back(), val));
+    int i = std::upper_bound(parent->keys, parent->keys + parent->count, val) - parent->keys;
+    if (i == parent->count) {
+        if (i == 0) {
+            unlockNode(parent);
+            return;
+        }
+        i--; // Merge into the left neighbour instead
+    }
+
+    // Leaves linked from a latched parent cannot be merged away by others
+    Node* left = parent->children[i];
+    Node* right = parent->children[i + 1];
+    lockNode(left);
+    lockNode(right);
+
+    bool merged = left->right == right && left->count + right->count <= BTREE_FANOUT / 2;
+    if (merged) {
+        std::copy(right->keys, right->keys + right->count, left->keys + left->count);
+        left->count += right->count;
+        left->highKey = right->highKey;
+        left->right = right->right;
+        right->dead = true;
+
+        // Drop the separator between the two and the link to 'right'
+        for (int j = i; j < parent->count - 1; ++j) {
+            parent->keys[j] = parent->keys[j + 1];
+        }
+        for (int j = i + 1; j < parent->count; ++j) {
+            parent->children[j] = parent->children[j + 1];
+        }
+        parent->count--;
+    }
+    unlockNode(right);
+    unlockNode(left);
+    unlockNode(parent);
+
+    if (merged) {
+        retireList.retire(right);
+        retireList.scanAndReclaim();
+    }
+}
+
+bool BLinkTree::contains(int val, int threadID) {
+    Node* leaf = descend(val, 0, nullptr, threadID);
+    while (true) {
+        uint64_t version = stableVersion(leaf);
+        if (leaf->dead) {
+            leaf = descend(val, 0, nullptr, threadID);
+            continue;
+        }
+        if (val >= leaf->highKey) {
+            Node* next = leaf->right;
+            protect(threadID, next, 1);
+            if (validate(leaf, version)) {
+                protect(threadID, next, 0);
+                leaf = next;
+            }
+            continue;
+        }
+
+        int i = lowerBound(leaf, val);
+        bool found = (i < leaf->count && leaf->keys[i] == val);
+        if (validate(leaf, version)) {
+            AccessedPointers::reset(threadID);
+            return found;
+        }
+        // Keys only move right, or left into this node by a merge, so retry in place
+    }
+}
+
+int BLinkTree::rangeScan(int lo, int hi, std::vector<int>& out, int threadID) {
+    if (lo > hi) {
+        return 0;
+    }
+
+    // Each leaf is read atomically; the scan as a whole is not a snapshot
+    int added = 0;
+    long long from = lo;
+    Node* leaf = descend(lo, 0, nullptr, threadID);
+    int buffer[BTREE_FANOUT];
+    while (leaf) {
+        uint64_t version = stableVersion(leaf);
+        if (leaf->dead) {
+            leaf = descend((int)from, 0, nullptr, threadID);
+            continue;
+        }
+        if (from >= leaf->highKey) {
+            Node* next = leaf->right;
+            protect(threadID, next, 1);
+            if (validate(leaf, version)) {
+                protect(threadID, next, 0);
+                leaf = next;
+            }
+            continue;
+        }
+
+        int n = 0;
+        int count = std::min(std::max(leaf->count, 0), BTREE_FANOUT);
+        for (int i = lowerBound(leaf, (int)from); i < count && leaf->keys[i] <= hi; ++i) {
+            buffer[n++] = leaf->keys[i];
+        }
+        long long high = leaf->highKey;
+        Node* next = leaf->right;
+        protect(threadID, next, 1);
+        if (!validate(leaf, version)) {
+            continue;
+        }
+
+        out.insert(out.end(), buffer, buffer + n);
+        added += n;
+        if (high > hi) {
+            break;
+        }
+        from = high;
+        protect(threadID, next, 0);
+        leaf = next;
+    }
+    AccessedPointers::reset(threadID);
+    return added;
+}
+
+void BLinkTree::printList() {
+    Node* curr = root.load(std::memory_order_acquire);
+    while (curr->level > 0) {
+        curr = static_cast<InnerNode*>(curr)->children[0];
+    }
+    while (curr) {
+        for (int i = 0; i < curr->count; ++i) {
+            std::cout << curr->keys[i] << " ";
+        }
+        curr = curr->right;
+    }
+    std::cout << std::endl;
+}
+
+int BLinkTree::get_length() {
+    return length;
+}
+
+int BLinkTree::get_height() {
+    return root.load(std::memory_order_acquire)->level + 1;
+}
+
+// Check every level: keys ascend across the level and stay below each
+// node's high key, and the leaves hold 'length' keys
+bool BLinkTree::checkList() {
+    Node* levelStart = root.load(std::memory_order_acquire);
+    while (levelStart) {
+        long long prev = LLONG_MIN;
+        int keys = 0;
+        for (Node* curr = levelStart; curr; curr = curr->right) {
+            for (int i = 0; i < curr->count; ++i) {
+                if (curr->keys[i] <= prev || curr->keys[i] >= curr->highKey) {
+                    return false;
+                }
+                prev = curr->keys[i];
+            }
+            keys += curr->count;
+            if (curr->dead) {
+                return false;
+            }
+            if (!curr->right && curr->highKey != LLONG_MAX) {
+                return false;
+            }
+        }
+        if (levelStart->level == 0) {
+            return keys == length;
+        }
+        levelStart = static_cast<InnerNode*>(levelStart)->children[0];
+    }
+    return true;
+}
@@ -0,0 +1,84 @@
+#ifndef BLINK_TREE_H
+#define BLINK_TREE_H
+
+#include <iostream>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <cstdint>
+
+#include "reclamation.hpp"
+
+#define BTREE_FANOUT 64 // Keys per node
+#define BTREE_MERGE_BELOW (BTREE_FANOUT / 4) // A leaf this sparse after a remove tries to merge
+
+// ------------------------------------------------------
+// Lehman-Yao B-link Tree
+// ------------------------------------------------------
+// Every node carries a high key and a right link, so a reader that lands
+// on a node which has split since it read the parent just follows 'right',
+// the same way MarkedList traversals follow 'next'. Readers never latch:
+// they read a node's version, read the node and re-check the version,
+// restarting on a concurrent change. Writers latch one node at a time
+// (plus its right sibling while moving right). A sparse leaf is merged
+// with a sibling under the same parent: the parent, then both leaves are
+// latched, the right leaf's keys move left and it is marked dead, unlinked
+// and retired. Readers publish the nodes they reach in their hazard slots
+// and restart from the root on a dead node. The first child of an inner
+// node is never merged away and inner nodes are never unlinked, so the
+// left edge of each level and every inner node live as long as the tree.
+class BLinkTree {
+private:
+    struct Node {
+        std::atomic<uint64_t> version; // Odd while a writer holds the latch
+        const int level;               // 0 for leaves
+        int count;
+        bool dead;                     // Merged into its left sibling and unlinked
+        long long highKey;             // Exclusive upper bound of this node's keys
+        Node* right;                   // Right sibling on the same level
+        int keys[BTREE_FANOUT];
+
+        explicit Node(int level);
+    };
+
+    struct InnerNode : Node {
+        Node* children[BTREE_FANOUT + 1]; // children[i] holds keys in [keys[i-1], keys[i])
+
+        explicit InnerNode(int level);
+    };
+
+    std::atomic<Node*> root;
+    std::mutex rootMutex; // Serializes growing the tree by one level
+    std::atomic<int> length;
+    RetireList<Node> retireList; // Merged leaves
+
+    static void protect(int threadID, Node* node, int slot);
+    static uint64_t stableVersion(Node* node);
+    static bool validate(Node* node, uint64_t version);
+    static void lockNode(Node* node);
+    static void unlockNode(Node* node);
+    static Node* lockAndMoveRight(Node* node, int val);
+    static int lowerBound(Node* node, int val);
+    static Node* childFor(InnerNode* node, int val);
+
+    Node* descend(int val, int level, std::vector<Node*>* path, int threadID);
+    void insertIntoParent(std::vector<Node*>& path, int level, Node* left, int separator, Node* right,
+                          int threadID);
+    void mergeLeaf(std::vector<Node*>& path, int val);
+
+public:
+    BLinkTree();
+    ~BLinkTree();
+
+    bool insert(int val, int threadID); // Insert 'val'; false if already present
+    bool remove(int val, int threadID); // Remove 'val' if it exists
+    bool contains(int val, int threadID); // Check if 'val' is in the tree
+    int rangeScan(int lo, int hi, std::vector<int>& out, int threadID); // Append keys in [lo, hi]
+
+    void printList(); // Print the keys in ascending order
+    int get_length();
+    int get_height();
+    bool checkList();
+};
+
+#endif
@@ -0,0 +1,279 @@
+#include "bounded-list.hpp"
+
+#include <climits>
+#include <thread>
+
+BoundedList::Node::Node(int val, Node* nxt)
+    : value(val), next(nxt), removed(false) {}
+
+BoundedList::BoundedList(int capacity, Evict evict)
+    : capacity(capacity), evict(evict), length(0), operationCounter(0) {
+    head = new Node(-1); // Sentinel with dummy value; never removed
+    threshold.store(emptyThreshold(), std::memory_order_relaxed);
+}
+
+BoundedList::~BoundedList() {
+    Node* curr = head;
+    while (curr) {
+        Node* temp = curr;
+        curr = curr->next;
+        delete temp;
+    }
+}
+
+bool BoundedList::precedes(int a, int b) const {
+    return evict == Evict::Smallest ? a < b : a > b;
+}
+
+int BoundedList::emptyThreshold() const {
+    return evict == Evict::Smallest ? INT_MIN : INT_MAX;
+}
+
+bool BoundedList::validate(Node* pred, Node* curr) {
+    return (!pred->removed && !(curr && curr->removed) && pred->next == curr);
+}
+
+void BoundedList::findWindow(int val, int threadID, Node*& pred, Node*& curr) {
+    while (true) {
+        // Publish each node before following it, then re-check that it is
+        // still linked behind a live predecessor; otherwise restart.
+        int slot = 0;
+        pred = head;
+        curr = pred->next;
+        AccessedPointers::store(threadID, curr, slot);
+        if (pred->next != curr) {
+            continue;
+        }
+
+        bool restart = false;
+        while (curr && precedes(curr->value, val)) {
+            Node* next = curr->next;
+            slot = 1 - slot;
+            AccessedPointers::store(threadID, next, slot);
+            if (curr->removed || curr->next != next) {
+                restart = true;
+                break;
+            }
+            pred = curr;
+            curr = next;
+        }
+
+        if (!restart) {
+            return;
+        }
+    }
+}
+
+void BoundedList::countOperation() {
+    if (operationCounter.fetch_add(1, std::memory_order_relaxed) + 1 >= length) {
+        scanAndReclaim();
+        operationCounter.fetch_sub(length, std::memory_order_relaxed);
+    }
+}
+
+void BoundedList::scanAndReclaim() {
+    retireList.scanAndReclaim();
+}
+
+bool BoundedList::insert(int val, int threadID, int* evicted) {
+    if (capacity <= 0) {
+        return false;
+    }
+
+    while (true) {
+        // (1) Reserve a free slot, if any; the list then cannot overflow
+        int n = length.load(std::memory_order_relaxed);
+        if (n < capacity) {
+            if (length.compare_exchange_weak(n, n + 1, std::memory_order_relaxed)) {
+                insertReserved(val, threadID);
+                countOperation();
+                return true;
+            }
+            continue;
+        }
+
+        // (2) Full: keys that do not beat the head never reach the list body
+        if (!precedes(threshold.load(std::memory_order_acquire), val)) {
+            return false;
+        }
+
+        // (3) Link 'val' and evict the head under one set of locks
+        if (insertEvicting(val, threadID, evicted)) {
+            countOperation();
+            return true;
+        }
+    }
+}
+
+void BoundedList::insertReserved(int val, int threadID) {
+    while (true) {
+        Node* pred;
+        Node* curr;
+        findWindow(val, threadID, pred, curr);
+
+        {
+            std::unique_lock<std::mutex> lockPred(pred->m);
+            std::unique_lock<std::mutex> lockCurr;
+            if (curr) {
+                lockCurr = std::unique_lock<std::mutex>(curr->m);
+            }
+
+            if (!validate(pred, curr)) {
+                AccessedPointers::reset(threadID);
+                continue;
+            }
+
+            pred->next = new Node(val, curr);
+            if (pred == head) {
+                threshold.store(val, std::memory_order_release);
+            }
+        }
+
+        AccessedPointers::reset(threadID);
+        return;
+    }
+}
+
+bool BoundedList::insertEvicting(int val, int threadID, int* evicted) {
+    Node* pred;
+    Node* curr;
+    findWindow(val, threadID, pred, curr);
+
+    // 'val' would become the new head, so it does not make the cut; the
+    // caller re-checks the threshold. An empty body means reserved
+    // inserts are still in flight.
+    if (pred == head) {
+        AccessedPointers::reset(threadID);
+        std::this_thread::yield();
+        return false;
+    }
+
+    Node* victim = nullptr;
+    {
+        // Lock in list order: head, victim, pred, curr. 'pred' was found
+        // without locks and may since have been unlinked ahead of the
+        // victim, so the trailing locks are only tried to avoid deadlock.
+        std::unique_lock<std::mutex> lockHead(head->m);
+        victim = head->next; // Stable while head is locked
+        if (!victim) {
+            AccessedPointers::reset(threadID);
+            return false;
+        }
+        std::unique_lock<std::mutex> lockVictim(victim->m);
+
+        std::unique_lock<std::mutex> lockPred;
+        if (pred != victim) {
+            lockPred = std::unique_lock<std::mutex>(pred->m, std::try_to_lock);
+        }
+        std::unique_lock<std::mutex> lockCurr;
+        if (curr && curr != victim) {
+            lockCurr = std::unique_lock<std::mutex>(curr->m, std::try_to_lock);
+        }
+
+        if ((pred != victim && !lockPred.owns_lock()) ||
+            (curr && curr != victim && !lockCurr.owns_lock()) ||
+            !validate(pred, curr) ||
+            length.load(std::memory_order_relaxed) < capacity) {
+            AccessedPointers::reset(threadID);
+            std::this_thread::yield();
+            return false;
+        }
+
+        pred->next = new Node(val, curr);
+
+        victim->removed = true;
+        head->next = victim->next; // Never null: the new node follows the victim
+        threshold.store(head->next->value, std::memory_order_release);
+        if (evicted) {
+            *evicted = victim->value;
+        }
+    }
+
+    retireList.retire(victim);
+    AccessedPointers::reset(threadID);
+    return true;
+}
+
+bool BoundedList::remove(int val, int threadID) {
+    while (true) {
+        Node* pred;
+        Node* curr;
+        findWindow(val, threadID, pred, curr);
+
+        {
+            std::unique_lock<std::mutex> lockPred(pred->m);
+            std::unique_lock<std::mutex> lockCurr;
+            if (curr) {
+                lockCurr = std::unique_lock<std::mutex>(curr->m);
+            }
+
+            if (!validate(pred, curr)) {
+                AccessedPointers::reset(threadID);
+                continue;
+            }
+
+            if (!curr || curr->value != val) {
+                AccessedPointers::reset(threadID);
+                return false;
+            }
+
+            curr->removed = true;
+            pred->next = curr->next;
+            if (pred == head) {
+                threshold.store(curr->next ? curr->next->value : emptyThreshold(),
+                                std::memory_order_release);
+            }
+
+            retireList.retire(curr);
+            AccessedPointers::reset(threadID);
+        }
+
+        length.fetch_sub(1, std::memory_order_relaxed);
+        countOperation();
+        return true;
+    }
+}
+
+bool BoundedList::contains(int val, int threadID) {
+    Node* pred;
+    Node* curr;
+    findWindow(val, threadID, pred, curr);
+
+    bool found = (curr && !curr->removed && curr->value == val);
+    AccessedPointers::reset(threadID);
+    return found;
+}
+
+void BoundedList::printList() {
+    Node* curr = head->next;
+    while (curr) {
+        if (!curr->removed) {
+            std::cout << curr->value << " ";
+        }
+        curr = curr->next;
+    }
+    std::cout << std::endl;
+}
+
+int BoundedList::get_length() {
+    return length;
+}
+
+int BoundedList::get_capacity() {
+    return capacity;
+}
+
+bool BoundedList::checkList() {
+    int count = 0;
+    Node* prev = nullptr;
+    Node* curr = head->next;
+    while (curr) {
+        if (prev && precedes(curr->value, prev->value)) {
+            return false;
+        }
+        prev = curr;
+        curr = curr->next;
+        count++;
+    }
+    return count <= capacity;
+}
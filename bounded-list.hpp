@@ -0,0 +1,65 @@
+#ifndef BOUNDED_LIST_H
+#define BOUNDED_LIST_H
+
+#include <iostream>
+#include <mutex>
+#include <atomic>
+
+#include "reclamation.hpp"
+
+// ------------------------------------------------------
+// Capacity-Bounded Sorted List (top-K with eviction)
+// ------------------------------------------------------
+// Nodes are kept in eviction order, so the element to evict is always
+// head->next. Inserting into a full list evicts that element under the
+// same locks that link the new node; keys that would not make the cut
+// are rejected against a cached threshold without traversing the list.
+class BoundedList {
+public:
+    enum class Evict { Smallest, Largest };
+
+private:
+    struct Node {
+        int value;
+        Node* next;
+        mutable std::mutex m; // Protects this node
+        bool removed;         // 'true' if this node is logically removed
+
+        Node(int val, Node* nxt = nullptr);
+    };
+
+    Node* head; // Sentinel node: never removed
+    RetireList<Node> retireList; // Nodes waiting to be freed
+    const int capacity;
+    const Evict evict;
+    std::atomic<int> length;     // Linked nodes plus slots reserved by in-flight inserts
+    std::atomic<int> threshold;  // Value of head->next; only updated while head is locked
+    std::atomic<int> operationCounter;
+
+    bool precedes(int a, int b) const; // 'a' is evicted before 'b'
+    int emptyThreshold() const;
+    bool validate(Node* pred, Node* curr);
+    void findWindow(int val, int threadID, Node*& pred, Node*& curr); // 'curr' is the first node not evicted before 'val'
+    void insertReserved(int val, int threadID);
+    bool insertEvicting(int val, int threadID, int* evicted);
+    void countOperation();
+
+public:
+    BoundedList(int capacity, Evict evict = Evict::Smallest);
+    ~BoundedList();
+
+    // Insert 'val'; when full, evict the head element if 'val' beats it.
+    // Returns false if 'val' was rejected. '*evicted' receives the evicted key.
+    bool insert(int val, int threadID, int* evicted = nullptr);
+    bool remove(int val, int threadID); // Remove 'val' if it exists
+    bool contains(int val, int threadID); // Check if 'val' is in the list
+
+    void scanAndReclaim(); // Scan and Reclaim Memory
+
+    void printList(); // Print the list contents in eviction order
+    int get_length();
+    int get_capacity();
+    bool checkList();
+};
+
+#endif
@@ -0,0 +1,125 @@
+#include "change-feed.hpp"
+
+#include <thread>
+
+#define STAMP_WRITING (1ull << 63)
+
+ChangeFeed::ChangeFeed(size_t capacity) : next(0), barrier(false) {
+    size_t size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    ring.reset(new Slot[size]);
+    mask = size - 1;
+    for (size_t i = 0; i < size; ++i) {
+        ring[i].stamp.store(0);
+        ring[i].payload.store(0);
+    }
+    for (UpdaterSlot& slot : updaters) {
+        slot.active.store(false);
+    }
+}
+
+// A slot can be claimed by two laps at once when producers wrap around the
+// ring. The later lap wins: an earlier one that finds a newer stamp leaves
+// its record out, and subscribers still waiting for it see that they lost it.
+uint64_t ChangeFeed::publish(Op op, int key) {
+    uint64_t seq = next.fetch_add(1);
+    Slot& slot = ring[seq & mask];
+    uint64_t stamp = seq + 1;
+    uint64_t cur = slot.stamp.load();
+    while (true) {
+        if ((cur & ~STAMP_WRITING) >= stamp) {
+            return seq;
+        }
+        if (cur & STAMP_WRITING) {
+            std::this_thread::yield(); // An earlier lap is still writing
+            cur = slot.stamp.load();
+            continue;
+        }
+        if (slot.stamp.compare_exchange_weak(cur, stamp | STAMP_WRITING)) {
+            break;
+        }
+    }
+    slot.payload.store(((uint64_t)op << 32) | (uint32_t)key, std::memory_order_relaxed);
+    slot.stamp.store(stamp, std::memory_order_release);
+    return seq;
+}
+
+uint64_t ChangeFeed::head() {
+    return next.load();
+}
+
+ChangeFeed::Subscriber ChangeFeed::subscribe() {
+    return Subscriber(*this, head());
+}
+
+// Same handshake as DurableList: an updater announces itself before checking
+// the barrier and quiesce() raises the barrier before checking the
+// announcements, so one of them always sees the other. Updaters wait while
+// holding their node locks; the snapshot walk takes no locks.
+void ChangeFeed::beginUpdate(int threadID) {
+    while (true) {
+        updaters[threadID].active.store(true);
+        if (!barrier.load()) {
+            return;
+        }
+        updaters[threadID].active.store(false);
+        while (barrier.load()) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void ChangeFeed::endUpdate(int threadID) {
+    updaters[threadID].active.store(false, std::memory_order_release);
+}
+
+void ChangeFeed::raiseBarrier() {
+    barrier.store(true);
+    for (UpdaterSlot& slot : updaters) {
+        while (slot.active.load()) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void ChangeFeed::lowerBarrier() {
+    barrier.store(false);
+}
+
+ChangeFeed::Subscriber::Subscriber(ChangeFeed& feed, uint64_t from) : feed(feed), next(from) {}
+
+// Each slot is read like a seqlock: the record is taken only if the stamp
+// matches before and after reading it
+bool ChangeFeed::Subscriber::poll(std::vector<Change>& out, size_t maxBatch) {
+    size_t taken = 0;
+    while (taken < maxBatch) {
+        Slot& slot = feed.ring[next & feed.mask];
+        uint64_t stamp = next + 1;
+        uint64_t before = slot.stamp.load(std::memory_order_acquire);
+        if ((before & ~STAMP_WRITING) > stamp) {
+            return false; // Overwritten by a later lap
+        }
+        if (before != stamp) {
+            break; // Not published yet
+        }
+        uint64_t payload = slot.payload.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.stamp.load(std::memory_order_relaxed) != before) {
+            continue; // Rewritten while reading; look again
+        }
+        out.push_back({next, (Op)(payload >> 32), (int)(uint32_t)payload});
+        next++;
+        taken++;
+    }
+    return true;
+}
+
+uint64_t ChangeFeed::Subscriber::position() {
+    return next;
+}
+
+void ChangeFeed::Subscriber::seek(uint64_t seq) {
+    next = seq;
+}
@@ -0,0 +1,99 @@
+#ifndef CHANGE_FEED_H
+#define CHANGE_FEED_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "reclamation.hpp"
+
+#define CHANGE_FEED_CAPACITY (1 << 16) // Changes a subscriber may fall behind before it must resync
+
+// ------------------------------------------------------
+// Change Feed
+// ------------------------------------------------------
+// A broadcast ring of (sequence, op, key) records. Producers claim the next
+// sequence number with one fetch_add and stamp the slot once it is written;
+// they never wait for subscribers. Every subscriber keeps its own position
+// and reads the records in batches. A slot's stamp tells a subscriber
+// whether its record is not yet written, ready, or already overwritten
+// by a later lap. The last case means the subscriber fell more than a
+// ring behind and must resync from a snapshot.
+//
+// A list with a feed attached publishes each update while holding the
+// update's node locks, so records for one key arrive in list order. The
+// list also brackets the update with beginUpdate/endUpdate. quiesce()
+// uses that to hold off updates briefly and produce a snapshot that
+// matches a sequence number exactly.
+class ChangeFeed {
+public:
+    enum class Op : uint8_t { Insert = 1, Remove = 2 };
+
+    struct Change {
+        uint64_t seq;
+        Op op;
+        int key;
+    };
+
+    class Subscriber {
+    public:
+        Subscriber(ChangeFeed& feed, uint64_t from);
+
+        // Append up to 'maxBatch' changes in sequence order; false if the
+        // next change was overwritten, so the caller must resync
+        bool poll(std::vector<Change>& out, size_t maxBatch);
+        uint64_t position(); // Sequence number of the next change to read
+        void seek(uint64_t seq);
+
+    private:
+        ChangeFeed& feed;
+        uint64_t next;
+    };
+
+    explicit ChangeFeed(size_t capacity = CHANGE_FEED_CAPACITY); // Rounded up to a power of two
+
+    uint64_t publish(Op op, int key); // Returns the change's sequence number
+    uint64_t head(); // Sequence number the next change will get
+    Subscriber subscribe(); // Starting at the next change
+
+    void beginUpdate(int threadID); // Waits while a snapshot is being taken
+    void endUpdate(int threadID);
+
+    // Hold off updates, run 'snapshot', and return the sequence number
+    // from which changes are not reflected in it
+    template <typename F>
+    uint64_t quiesce(F snapshot) {
+        std::lock_guard<std::mutex> guard(quiesceMutex);
+        raiseBarrier();
+        snapshot();
+        uint64_t seq = head();
+        lowerBarrier();
+        return seq;
+    }
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> stamp;   // Sequence + 1 of the record; STAMP_WRITING is set while it is written
+        std::atomic<uint64_t> payload; // Op in the high half, key in the low half
+    };
+
+    struct alignas(64) UpdaterSlot {
+        std::atomic<bool> active;
+    };
+
+    std::unique_ptr<Slot[]> ring;
+    uint64_t mask;
+    alignas(64) std::atomic<uint64_t> next;
+
+    UpdaterSlot updaters[MAX_THREADS];
+    std::atomic<bool> barrier;
+    std::mutex quiesceMutex;
+
+    void raiseBarrier();
+    void lowerBarrier();
+};
+
+#endif
@@ -1,17 +1,22 @@
 #include "concurrent-linked-list.hpp"
 
-std::atomic<MarkedList::Node*> MarkedList::accessedPointers[MAX_THREADS][ACCESSED_PTRS_PER_THREAD];
+#include <algorithm>
+#include <climits>
 
-MarkedList::Node::Node(int val, Node* nxt)
-    : value(val), next(nxt), removed(false) {}
+#include "change-feed.hpp"
+#include "serialization.hpp"
+#include "wait-table.hpp"
 
-MarkedList::MarkedList() : length(0), operationCounter(0) {
+MarkedList::Node::Node(int val, Node* nxt, bool chunked)
+    : value(val), next(nxt), removed(false), chunked(chunked), sampled(false) {}
+
+MarkedList::MarkedList()
+    : retireList(releaseNode), length(0), operationCounter(0), feed(nullptr), barrier(false), relinks(0), waits(nullptr) {
     head = new Node(-1); // Sentinel with dummy value; never removed
-    for (int i = 0; i < MAX_THREADS; ++i) {
-        for (int j = 0; j < ACCESSED_PTRS_PER_THREAD; ++j) {
-            accessedPointers[i][j].store(nullptr, std::memory_order_relaxed);
-        }
+    for (UpdaterSlot& slot : updaters) {
+        slot.active.store(0);
     }
+    retireList.setHold([](Node* node) { return node->sampled.load(); });
 }
 
 MarkedList::~MarkedList() {
@@ -19,7 +24,17 @@ MarkedList::~MarkedList() {
     while (curr) {
         Node* temp = curr;
         curr = curr->next;
-        delete temp;
+        releaseNode(temp);
+    }
+    delete waits.load();
+}
+
+// Chunked nodes are only destroyed here; their storage goes with 'chunks'
+void MarkedList::releaseNode(Node* node) {
+    if (node->chunked) {
+        node->~Node();
+    } else {
+        delete node;
     }
 }
 
@@ -28,55 +43,100 @@ bool MarkedList::validate(Node* pred, Node* curr) {
 }
 
 void MarkedList::storeAccessedPointer(int threadID, Node* node, int index) {
-    accessedPointers[threadID][index].store(node, std::memory_order_release);
+    AccessedPointers::store(threadID, node, index);
 }
 
 void MarkedList::resetAccessedPointer(int threadID) {
-    for(int i = 0; i < ACCESSED_PTRS_PER_THREAD; i++) {
-        accessedPointers[threadID][i].store(nullptr, std::memory_order_release);
-    }
+    AccessedPointers::reset(threadID);
 }
 
-bool MarkedList::isNodeAccessed(Node* node) {
-    for (int i = 0; i < MAX_THREADS; ++i) {
-        for(int j = 0; j < ACCESSED_PTRS_PER_THREAD; j++) {
-            if (accessedPointers[i][j].load(std::memory_order_acquire) == node) {
-                return true;
-            }
+// Same handshake as DurableList: an updater announces itself before checking
+// the barrier, and split or splice raises the barrier before checking the
+// announcements, so one of them always sees the other
+void MarkedList::beginUpdate(int threadID) {
+    std::atomic<int>& active = updaters[threadID].active;
+    if (active.load(std::memory_order_relaxed) > 0) {
+        active.fetch_add(1); // Already admitted by an enclosing call
+        return;
+    }
+    while (true) {
+        active.store(1);
+        if (!barrier.load()) {
+            return;
+        }
+        active.store(0);
+        while (barrier.load()) {
+            std::this_thread::yield();
         }
     }
-    return false;
 }
 
-void MarkedList::scanAndReclaim() {
-    std::lock_guard<std::mutex> lock(retireMutex);
-    std::vector<Node*> newRetireList;
+void MarkedList::endUpdate(int threadID) {
+    updaters[threadID].active.fetch_sub(1, std::memory_order_release);
+}
 
-    for (Node* node : retireList) {
-        if (!isNodeAccessed(node)) {
-            // std::cerr << "Deleted: " << node->value << std::endl;
-            delete node; // Safe to free
-        } else {
-            newRetireList.push_back(node);
+// Called with 'sampleMutex' held, which also keeps parallel scans out
+void MarkedList::raiseBarrier() {
+    barrier.store(true);
+    for (UpdaterSlot& slot : updaters) {
+        while (slot.active.load() > 0) {
+            std::this_thread::yield();
         }
     }
+    resample({});
+}
 
-    retireList = std::move(newRetireList);
+void MarkedList::lowerBarrier() {
+    barrier.store(false);
 }
 
-void MarkedList::insert(int val, int threadID) {
+void MarkedList::scanAndReclaim() {
+    retireList.scanAndReclaim();
+}
+
+int MarkedList::findWindow(int val, int threadID, Node*& pred, Node*& curr, Node* start,
+                           int startSlot) {
     while (true) {
-        Node* pred = head;
-        storeAccessedPointer(threadID, pred->next, 0);
-        Node* curr = pred->next;
-        
-        // (1) Traverse without locks
+        // Publish each node before following it, then re-check that it is
+        // still linked behind a live predecessor; otherwise restart.
+        int slot = 1 - startSlot;
+        pred = start ? start : head;
+        curr = pred->next;
+        storeAccessedPointer(threadID, curr, slot);
+        if (pred->removed || pred->next != curr) {
+            start = nullptr; // Removed since it was published; start over from head
+            startSlot = 1;
+            continue;
+        }
+
+        bool restart = false;
         while (curr && curr->value < val) {
-            storeAccessedPointer(threadID, curr, 0);
+            Node* next = curr->next;
+            slot = 1 - slot;
+            storeAccessedPointer(threadID, next, slot);
+            if (curr->removed || curr->next != next) {
+                restart = true;
+                break;
+            }
             pred = curr;
-            storeAccessedPointer(threadID, curr->next, 1);
-            curr = curr->next;
+            curr = next;
         }
+
+        if (!restart) {
+            return slot;
+        }
+        start = nullptr;
+        startSlot = 1;
+    }
+}
+
+void MarkedList::insert(int val, int threadID) {
+    beginUpdate(threadID);
+    while (true) {
+        // (1) Traverse without locks
+        Node* pred;
+        Node* curr;
+        findWindow(val, threadID, pred, curr);
         
         // (2) Lock pred
         {
@@ -96,11 +156,19 @@ void MarkedList::insert(int val, int threadID) {
             
             // safely insert b/c 'curr' is either null or has a value >= val
             Node* newNode = new Node(val, curr);
+            if (feed) {
+                feed->beginUpdate(threadID);
+            }
             pred->next = newNode;
+            if (feed) {
+                feed->publish(ChangeFeed::Op::Insert, val);
+                feed->endUpdate(threadID);
+            }
         }
         // locks unlock automatically at scope exit
 
         resetAccessedPointer(threadID);
+        wakeWaiters(val);
 
         length.fetch_add(1, std::memory_order_relaxed);
         if (operationCounter.fetch_add(1, std::memory_order_relaxed) + 1 >= length) {
@@ -108,23 +176,18 @@ void MarkedList::insert(int val, int threadID) {
             operationCounter.fetch_sub(length, std::memory_order_relaxed);
         }
 
+        endUpdate(threadID);
         return;
     }
 }
 
 bool MarkedList::remove(int val, int threadID) {
+    beginUpdate(threadID);
     while (true) {
-        Node* pred = head;
-        Node* curr = pred->next;
-        storeAccessedPointer(threadID, pred->next, 0);
-        
         // (1) Traverse without locks
-        while (curr && curr->value < val) {
-            storeAccessedPointer(threadID, curr, 0);
-            pred = curr;
-            storeAccessedPointer(threadID, curr->next, 1);
-            curr = curr->next;
-        }
+        Node* pred;
+        Node* curr;
+        findWindow(val, threadID, pred, curr);
 
         // (2) Lock pred
         {
@@ -145,20 +208,25 @@ bool MarkedList::remove(int val, int threadID) {
             // If 'curr' is null or doesn't match val, not found
             if (!curr || curr->value != val) {
                 resetAccessedPointer(threadID);
+                endUpdate(threadID);
                 return false;
             }
             
             // (5) Logically remove by setting 'removed = true'
+            if (feed) {
+                feed->beginUpdate(threadID);
+            }
             curr->removed = true;
 
             // (6) Physically unlink from pred
             pred->next = curr->next;
+            if (feed) {
+                feed->publish(ChangeFeed::Op::Remove, val);
+                feed->endUpdate(threadID);
+            }
 
              // Add to retire list instead of freeing immediately
-            {
-                std::lock_guard<std::mutex> lock(retireMutex);
-                retireList.push_back(curr);
-            }
+            retireList.retire(curr);
             resetAccessedPointer(threadID);
         }
 
@@ -169,23 +237,879 @@ bool MarkedList::remove(int val, int threadID) {
         }
         // 'curr' is not freed; it remains for potential safe reclamation
         
+        endUpdate(threadID);
         return true;
     }
 }
 
+int MarkedList::removeIf(const std::function<bool(int)>& pred, int threadID) {
+    return removeIf(INT_MIN, INT_MAX, pred, threadID);
+}
+
+// One walk from the first key >= lo. 'prev' and 'curr' always sit in the two
+// traversal slots; a matching node is locked and unlinked like remove()
+// does, and the walk goes on from its successor. When the window changed
+// underneath, the walk resumes from a protected node rather than from head. Removed
+// nodes are retired together at the end.
+int MarkedList::removeIf(int lo, int hi, const std::function<bool(int)>& pred, int threadID) {
+    if (lo > hi) {
+        return 0;
+    }
+    beginUpdate(threadID);
+    std::vector<Node*> batch;
+    Node* prev;
+    Node* curr;
+    int slot = findWindow(lo, threadID, prev, curr);
+
+    while (curr && curr->value <= hi) {
+        int val = curr->value;
+        if (curr->removed || !pred(val)) {
+            Node* next = curr->next;
+            storeAccessedPointer(threadID, next, 1 - slot);
+            if (curr->removed || curr->next != next) {
+                // 'prev' just lost its slot; resume past 'curr' instead
+                slot = findWindow(val, threadID, prev, curr, curr, slot);
+                continue;
+            }
+            prev = curr;
+            curr = next;
+            slot = 1 - slot;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lockPrev(prev->m);
+        std::unique_lock<std::mutex> lockCurr(curr->m);
+        if (!validate(prev, curr)) {
+            lockCurr.unlock();
+            lockPrev.unlock();
+            slot = findWindow(val, threadID, prev, curr, prev, 1 - slot);
+            continue;
+        }
+
+        if (feed) {
+            feed->beginUpdate(threadID);
+        }
+        curr->removed = true;
+        prev->next = curr->next;
+        if (feed) {
+            feed->publish(ChangeFeed::Op::Remove, val);
+            feed->endUpdate(threadID);
+        }
+        batch.push_back(curr);
+
+        // 'prev' is locked, so the successor cannot be unlinked before it
+        // takes over the slot
+        curr = prev->next;
+        storeAccessedPointer(threadID, curr, slot);
+    }
+    resetAccessedPointer(threadID);
+
+    int count = (int)batch.size();
+    retireList.retire(batch);
+    recordUpdates(-count, count);
+    endUpdate(threadID);
+    return count;
+}
+
+// Ops are taken in ascending key order; each window search resumes from
+// the previous op's predecessor, which stays published in its slot
+void MarkedList::applySorted(const std::vector<BatchOp>& ops, const int* order, int count,
+                             uint8_t* results, int threadID) {
+    beginUpdate(threadID);
+    std::vector<Node*> batch;
+    int inserted = 0;
+    Node* start = nullptr;
+    int startSlot = 1;
+
+    for (int i = 0; i < count; ++i) {
+        const BatchOp& op = ops[order[i]];
+        int val = op.key;
+        while (true) {
+            Node* pred;
+            Node* curr;
+            int predSlot = 1 - findWindow(val, threadID, pred, curr, start, startSlot);
+            start = pred;
+            startSlot = predSlot;
+
+            if (op.type == BatchOp::Type::Contains) {
+                results[order[i]] = (curr && !curr->removed && curr->value == val);
+                break;
+            }
+
+            std::unique_lock<std::mutex> lockPred(pred->m);
+            std::unique_lock<std::mutex> lockCurr;
+            if (curr) {
+                lockCurr = std::unique_lock<std::mutex>(curr->m);
+            }
+            if (!validate(pred, curr)) {
+                continue;
+            }
+
+            if (op.type == BatchOp::Type::Insert) {
+                Node* newNode = new Node(val, curr);
+                if (feed) {
+                    feed->beginUpdate(threadID);
+                }
+                pred->next = newNode;
+                if (feed) {
+                    feed->publish(ChangeFeed::Op::Insert, val);
+                    feed->endUpdate(threadID);
+                }
+                inserted++;
+                results[order[i]] = 1;
+            } else if (curr && curr->value == val) {
+                if (feed) {
+                    feed->beginUpdate(threadID);
+                }
+                curr->removed = true;
+                pred->next = curr->next;
+                if (feed) {
+                    feed->publish(ChangeFeed::Op::Remove, val);
+                    feed->endUpdate(threadID);
+                }
+                batch.push_back(curr);
+                results[order[i]] = 1;
+            } else {
+                results[order[i]] = 0;
+            }
+            break;
+        }
+        if (op.type == BatchOp::Type::Insert) {
+            wakeWaiters(val);
+        }
+    }
+    resetAccessedPointer(threadID);
+
+    retireList.retire(batch);
+    recordUpdates(inserted - (int)batch.size(), inserted + (int)batch.size());
+    endUpdate(threadID);
+}
+
+// Ops are sorted by key, keeping their order within a key, and cut into
+// ranges that never split a key. Ranges are disjoint, so the threads
+// rarely meet on a node lock.
+bool MarkedList::applyBatch(const std::vector<BatchOp>& ops, std::vector<uint8_t>& results,
+                            ThreadPool& pool, int firstThreadID) {
+    if (firstThreadID < 0 || firstThreadID + pool.size() > MAX_THREADS) {
+        return false;
+    }
+    int n = (int)ops.size();
+    results.assign(n, 0);
+    std::vector<int> order(n);
+    for (int i = 0; i < n; ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return ops[a].key < ops[b].key; });
+
+    int ranges = std::max(1, std::min(n, pool.size() * BATCH_RANGES_PER_THREAD));
+    std::vector<int> cuts(ranges + 1, n);
+    cuts[0] = 0;
+    for (int r = 1; r < ranges; ++r) {
+        int cut = std::max(cuts[r - 1], (int)((long long)n * r / ranges));
+        while (cut > 0 && cut < n && ops[order[cut]].key == ops[order[cut - 1]].key) {
+            cut++;
+        }
+        cuts[r] = cut;
+    }
+
+    pool.parallelFor(ranges, [&](int r, int thread) {
+        if (cuts[r] < cuts[r + 1]) {
+            applySorted(ops, order.data() + cuts[r], cuts[r + 1] - cuts[r], results.data(),
+                        firstThreadID + thread);
+        }
+    });
+    return true;
+}
+
+// A split or splice during the search may have moved the nodes it walked
+// to another list, so the search is repeated if 'relinks' changed
 bool MarkedList::contains(int val, int threadID) {
     while (true) {
-        Node* curr = head->next;
-        storeAccessedPointer(threadID, curr, 0);
-        while (curr && curr->value < val) {
-            curr = curr->next;
-            storeAccessedPointer(threadID, curr, 0);
-        }
+        uint64_t seen = relinks.load();
+        Node* pred;
+        Node* curr;
+        findWindow(val, threadID, pred, curr);
 
         bool found = (curr && !curr->removed && curr->value == val);
         resetAccessedPointer(threadID);
-        return found;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (relinks.load(std::memory_order_relaxed) == seen) {
+            return found;
+        }
+    }
+}
+
+// The first waiter creates the wait table; until then an insert only
+// finds it missing
+bool MarkedList::waitFor(int val, std::chrono::nanoseconds timeout, int threadID) {
+    timeout = std::min<std::chrono::nanoseconds>(timeout, std::chrono::hours(24 * 365)); // Keep the deadline in range
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    WaitTable* table = waits.load();
+    if (!table) {
+        WaitTable* created = new WaitTable();
+        if (waits.compare_exchange_strong(table, created)) {
+            table = created;
+        } else {
+            delete created;
+        }
+    }
+    return table->waitUntil(val, deadline, [&] { return contains(val, threadID); });
+}
+
+// The key is linked before the fence, and a waiter registers in its bucket
+// before it checks the list, so either the waiter finds the key or this
+// finds the waiter
+void MarkedList::wakeWaiters(int val) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    WaitTable* table = waits.load(std::memory_order_relaxed);
+    if (table) {
+        table->wake(val);
+    }
+}
+
+void MarkedList::wakeAllWaiters() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    WaitTable* table = waits.load(std::memory_order_relaxed);
+    if (table) {
+        table->wakeAll();
+    }
+}
+
+void MarkedList::setChangeFeed(ChangeFeed* feed) {
+    this->feed = feed;
+}
+
+// Updates are published under their node locks, so holding them off at the
+// feed leaves the list matching the feed's head exactly
+std::vector<int> MarkedList::snapshot(uint64_t& seq) {
+    if (!feed) {
+        seq = 0;
+        return keys();
+    }
+    std::vector<int> out;
+    seq = feed->quiesce([&] { out = keys(); });
+    return out;
+}
+
+// Each window search resumes from the node inserted last, which stays
+// published in the slot its predecessor had
+void MarkedList::insertSorted(const std::vector<int>& sortedKeys, int threadID) {
+    beginUpdate(threadID); // For the whole pass: a split could move 'start' to another list
+    Node* start = nullptr;
+    int startSlot = 1;
+    for (int val : sortedKeys) {
+        while (true) {
+            Node* pred;
+            Node* curr;
+            int predSlot = 1 - findWindow(val, threadID, pred, curr, start, startSlot);
+
+            std::unique_lock<std::mutex> lockPred(pred->m);
+            std::unique_lock<std::mutex> lockCurr;
+            if (curr) {
+                lockCurr = std::unique_lock<std::mutex>(curr->m);
+            }
+            if (!validate(pred, curr)) {
+                continue;
+            }
+
+            Node* newNode = new Node(val, curr);
+            if (feed) {
+                feed->beginUpdate(threadID);
+            }
+            pred->next = newNode;
+            if (feed) {
+                feed->publish(ChangeFeed::Op::Insert, val);
+                feed->endUpdate(threadID);
+            }
+            storeAccessedPointer(threadID, newNode, predSlot);
+            start = newNode;
+            startSlot = predSlot;
+            break;
+        }
+        wakeWaiters(val);
+    }
+    resetAccessedPointer(threadID);
+    recordUpdates((int)sortedKeys.size(), (int)sortedKeys.size());
+    endUpdate(threadID);
+}
+
+void MarkedList::recordUpdates(int lengthDelta, int count) {
+    if (count == 0) {
+        return;
+    }
+    length.fetch_add(lengthDelta, std::memory_order_relaxed);
+    if (operationCounter.fetch_add(count, std::memory_order_relaxed) + count >= length) {
+        scanAndReclaim();
+        operationCounter.fetch_sub(length, std::memory_order_relaxed);
+    }
+}
+
+// Both lists are walked once, side by side, under their scan guards
+void MarkedList::merge(MarkedList& other, SetOp op, const std::function<void(int)>& emit) {
+    RetireList<Node>::ScanGuard guard(retireList);
+    RetireList<Node>::ScanGuard otherGuard(other.retireList);
+    auto live = [](Node* node) {
+        while (node && node->removed) {
+            node = node->next;
+        }
+        return node;
+    };
+
+    Node* a = live(head->next);
+    Node* b = live(other.head->next);
+    while (a && (b || op != SetOp::Intersection)) {
+        if (!b || a->value < b->value) {
+            if (op != SetOp::Intersection) {
+                emit(a->value);
+            }
+            a = live(a->next);
+        } else if (b->value < a->value) {
+            if (op == SetOp::Union) {
+                emit(b->value);
+            }
+            b = live(b->next);
+        } else {
+            if (op != SetOp::Difference) {
+                emit(a->value);
+            }
+            a = live(a->next);
+            b = live(b->next);
+        }
+    }
+    for (; b && op == SetOp::Union; b = live(b->next)) {
+        emit(b->value);
+    }
+}
+
+bool MarkedList::mergeInto(MarkedList& other, SetOp op, MarkedList& result) {
+    std::vector<int> keys;
+    merge(other, op, [&](int key) { keys.push_back(key); });
+    return result.bulkLoad(keys);
+}
+
+void MarkedList::mergeFrom(MarkedList& other, int threadID) {
+    std::vector<int> missing;
+    other.merge(*this, SetOp::Difference, [&](int key) { missing.push_back(key); });
+    insertSorted(missing, threadID);
+}
+
+bool MarkedList::publishChain(Node* first, int count) {
+    bool published = false;
+    {
+        std::lock_guard<std::mutex> lockHead(head->m);
+        if (!head->next) {
+            head->next = first;
+            length.fetch_add(count, std::memory_order_relaxed);
+            published = true;
+        }
+    }
+
+    if (!published) {
+        freeChain(first);
+        return false;
+    }
+    wakeAllWaiters();
+    return true;
+}
+
+void MarkedList::freeChain(Node* first) {
+    while (first) {
+        Node* temp = first;
+        first = first->next;
+        releaseNode(temp);
+    }
+}
+
+bool MarkedList::save(int fd) {
+    RetireList<Node>::ScanGuard guard(retireList);
+    SnapshotWriter writer(fd);
+    long long prev = INT_MIN;
+    Node* curr = head->next;
+    while (curr) {
+        if (!curr->removed && curr->value >= prev) {
+            writer.add(curr->value);
+            prev = curr->value;
+        }
+        curr = curr->next;
+    }
+    return writer.finish();
+}
+
+bool MarkedList::load(int fd) {
+    // Build the chain privately; nothing is locked until it is published
+    SnapshotReader reader(fd);
+    Node* first = nullptr;
+    Node** tail = &first;
+    int count = 0;
+    int key;
+    while (reader.next(key)) {
+        *tail = new Node(key);
+        tail = &(*tail)->next;
+        count++;
+    }
+
+    if (!reader.finish()) {
+        freeChain(first);
+        return false;
     }
+    return publishChain(first, count);
+}
+
+bool MarkedList::bulkLoad(const std::vector<int>& sortedKeys) {
+    if (!std::is_sorted(sortedKeys.begin(), sortedKeys.end())) {
+        return false;
+    }
+
+    Node* first = nullptr;
+    Node** tail = &first;
+    for (int key : sortedKeys) {
+        *tail = new Node(key);
+        tail = &(*tail)->next;
+    }
+    return publishChain(first, (int)sortedKeys.size());
+}
+
+// Sort the slices in parallel and merge them pairwise, then let each thread
+// build one slice's nodes in a single allocation. The slices are spliced
+// end to end and published like bulkLoad.
+bool MarkedList::parallelBuild(std::vector<int> keys, int numThreads) {
+    if (head->next) {
+        return false;
+    }
+    size_t n = keys.size();
+    numThreads = (int)std::max<size_t>(1, std::min<size_t>(std::max(numThreads, 1), n));
+    std::vector<size_t> bounds(numThreads + 1);
+    for (int t = 0; t <= numThreads; ++t) {
+        bounds[t] = n * t / numThreads;
+    }
+
+    auto forEachSlice = [&](int count, auto work) {
+        std::vector<std::thread> threads;
+        for (int t = 1; t < count; ++t) {
+            threads.emplace_back(work, t);
+        }
+        work(0);
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    };
+
+    forEachSlice(numThreads, [&](int t) {
+        std::sort(keys.begin() + bounds[t], keys.begin() + bounds[t + 1]);
+    });
+    for (int width = 1; width < numThreads; width *= 2) {
+        int merges = (numThreads + 2 * width - 1) / (2 * width);
+        forEachSlice(merges, [&](int m) {
+            int lo = 2 * width * m;
+            int mid = std::min(lo + width, numThreads);
+            int hi = std::min(lo + 2 * width, numThreads);
+            std::inplace_merge(keys.begin() + bounds[lo], keys.begin() + bounds[mid],
+                               keys.begin() + bounds[hi]);
+        });
+    }
+
+    std::vector<std::shared_ptr<unsigned char[]>> storage(numThreads);
+    forEachSlice(numThreads, [&](int t) {
+        size_t count = bounds[t + 1] - bounds[t];
+        storage[t].reset(new unsigned char[count * sizeof(Node)]);
+        Node* nodes = reinterpret_cast<Node*>(storage[t].get());
+        for (size_t i = count; i-- > 0;) {
+            new (&nodes[i]) Node(keys[bounds[t] + i], (i + 1 < count) ? &nodes[i + 1] : nullptr, true);
+        }
+    });
+
+    // Also pick split nodes so the first parallel scan is balanced
+    size_t step = std::max<size_t>(1, n / (numThreads * PARALLEL_SCAN_SEGMENTS_PER_THREAD));
+    std::vector<std::vector<Node*>> picked(numThreads);
+    Node* first = nullptr;
+    Node** tail = &first;
+    for (int t = 0; t < numThreads; ++t) {
+        size_t count = bounds[t + 1] - bounds[t];
+        Node* nodes = reinterpret_cast<Node*>(storage[t].get());
+        for (size_t i = 0; i < count; i += step) {
+            picked[t].push_back(&nodes[i]);
+        }
+        if (count > 0) {
+            *tail = nodes;
+            tail = &nodes[count - 1].next;
+        }
+    }
+
+    bool published = false;
+    {
+        std::lock_guard<std::mutex> lockSamples(sampleMutex);
+        std::lock_guard<std::mutex> lockHead(head->m);
+        if (!head->next) {
+            chunks.insert(chunks.end(), storage.begin(), storage.end());
+            head->next = first;
+            length.fetch_add((int)n, std::memory_order_relaxed);
+            resample(picked);
+            published = true;
+        }
+    }
+
+    if (!published) {
+        freeChain(first); // Another load won the race; 'storage' frees the chunks
+        return false;
+    }
+    wakeAllWaiters();
+    return true;
+}
+
+// Each attached feed once, so a feed shared by both lists is not entered twice
+static std::vector<ChangeFeed*> feedsOf(ChangeFeed* a, ChangeFeed* b) {
+    std::vector<ChangeFeed*> feeds;
+    if (a) {
+        feeds.push_back(a);
+    }
+    if (b && b != a) {
+        feeds.push_back(b);
+    }
+    return feeds;
+}
+
+// Count the chain starting at 'moved', which now belongs to 'to', and
+// publish each key as a remove from 'from' and an insert into 'to'. The
+// walk is skipped when neither the count nor a feed is needed.
+int MarkedList::publishMoved(MarkedList& from, MarkedList& to, Node* moved, bool count) {
+    if (!count && !from.feed && !to.feed) {
+        return 0;
+    }
+    int n = 0;
+    for (Node* node = moved; node; node = node->next) {
+        n++;
+        if (from.feed) {
+            from.feed->publish(ChangeFeed::Op::Remove, node->value);
+        }
+        if (to.feed) {
+            to.feed->publish(ChangeFeed::Op::Insert, node->value);
+        }
+    }
+    return n;
+}
+
+// The split point is found by an ordinary traversal, with writers still
+// running, and both barriers go up only to check that it still holds and
+// relink. The chain leaves 'this' with one locked pointer update, after
+// which writers of 'this' may go on. 'into' keeps its barrier while the
+// moved chain is counted and, with a feed attached, published: with no
+// update in flight it holds only live nodes. The moved keys go out as
+// removes from 'this' and inserts into 'into', inside one update of each
+// feed, so a snapshot quiesced on either feed sees each key in exactly
+// one list.
+//
+// Bumping 'relinks' on both lists makes a contains() that was parked on a
+// moved node search again, rather than follow the chain on into keys
+// that were never in its list. Scans of 'this' that may still walk the
+// moved nodes are waited out before 'into' admits updates that free them.
+bool MarkedList::split(int key, MarkedList& into, int threadID) {
+    if (&into == this) {
+        return false;
+    }
+    MarkedList* first = std::min(this, &into);
+    MarkedList* second = std::max(this, &into);
+    std::lock(first->sampleMutex, second->sampleMutex);
+    std::lock_guard<std::mutex> lockFirst(first->sampleMutex, std::adopt_lock);
+    std::lock_guard<std::mutex> lockSecond(second->sampleMutex, std::adopt_lock);
+
+    Node* moved = nullptr;
+    while (true) {
+        Node* pred;
+        Node* curr;
+        findWindow(key, threadID, pred, curr); // Keeps 'pred' published
+        first->raiseBarrier();
+        second->raiseBarrier();
+        if (!pred->removed) {
+            // With the barriers up nothing moves, so keys linked after the
+            // search can simply be stepped over
+            while (pred->next && pred->next->value < key) {
+                pred = pred->next;
+            }
+            curr = pred->next;
+            // The heads are locked so a concurrent bulk load cannot publish
+            // into either list meanwhile
+            std::lock(head->m, into.head->m);
+            std::lock_guard<std::mutex> lockHead(head->m, std::adopt_lock);
+            std::lock_guard<std::mutex> lockInto(into.head->m, std::adopt_lock);
+            if (into.head->next) {
+                break; // Not empty
+            }
+            std::unique_lock<std::mutex> lockPred;
+            if (pred != head) {
+                lockPred = std::unique_lock<std::mutex>(pred->m);
+            }
+            moved = curr;
+            for (ChangeFeed* f : feedsOf(feed, into.feed)) {
+                f->beginUpdate(threadID);
+            }
+            relinks.fetch_add(1);
+            into.relinks.fetch_add(1);
+            into.head->next = moved;
+            pred->next = nullptr;
+            into.chunks.insert(into.chunks.end(), chunks.begin(), chunks.end());
+            break;
+        }
+        second->lowerBarrier();
+        first->lowerBarrier(); // 'pred' went away meanwhile; search again
+    }
+    resetAccessedPointer(threadID);
+    if (!moved) {
+        second->lowerBarrier();
+        first->lowerBarrier();
+        return false;
+    }
+    lowerBarrier();
+
+    int count = publishMoved(*this, into, moved, true);
+    for (ChangeFeed* f : feedsOf(feed, into.feed)) {
+        f->endUpdate(threadID);
+    }
+    length.fetch_sub(count);
+    into.length.fetch_add(count);
+    retireList.waitForScans();
+    into.lowerBarrier();
+    into.wakeAllWaiters();
+    return true;
+}
+
+// Like split: the tail is found before the barriers go up, and 'other'
+// may take updates again as soon as its chain is detached. Its length
+// moves over whole, so 'this' keeps its barrier for longer only to
+// publish the keys to a feed and to wait out scans of 'other'.
+bool MarkedList::splice(MarkedList& other, int threadID) {
+    if (&other == this) {
+        return false;
+    }
+    MarkedList* first = std::min(this, &other);
+    MarkedList* second = std::max(this, &other);
+    std::lock(first->sampleMutex, second->sampleMutex);
+    std::lock_guard<std::mutex> lockFirst(first->sampleMutex, std::adopt_lock);
+    std::lock_guard<std::mutex> lockSecond(second->sampleMutex, std::adopt_lock);
+
+    Node* moved = nullptr;
+    bool ok = true;
+    while (true) {
+        Node* pred;
+        Node* tail;
+        findWindow(INT_MAX, threadID, pred, tail); // Keeps the last two nodes published
+        tail = tail ? tail : pred; // Only keys equal to INT_MAX can follow 'pred'
+        first->raiseBarrier();
+        second->raiseBarrier();
+        if (!tail->removed) {
+            while (tail->next) {
+                tail = tail->next; // Appended after the search
+            }
+            std::lock(head->m, other.head->m);
+            std::lock_guard<std::mutex> lockHead(head->m, std::adopt_lock);
+            std::lock_guard<std::mutex> lockOther(other.head->m, std::adopt_lock);
+            moved = other.head->next;
+            ok = (!moved || tail == head || tail->value < moved->value);
+            if (!moved || !ok) {
+                moved = nullptr;
+                break;
+            }
+            std::unique_lock<std::mutex> lockTail;
+            if (tail != head) {
+                lockTail = std::unique_lock<std::mutex>(tail->m);
+            }
+            for (ChangeFeed* f : feedsOf(other.feed, feed)) {
+                f->beginUpdate(threadID);
+            }
+            relinks.fetch_add(1);
+            other.relinks.fetch_add(1);
+            tail->next = moved;
+            other.head->next = nullptr;
+            length.fetch_add(other.length.exchange(0));
+            chunks.insert(chunks.end(), other.chunks.begin(), other.chunks.end());
+            break;
+        }
+        second->lowerBarrier();
+        first->lowerBarrier(); // The tail was removed meanwhile; search again
+    }
+    resetAccessedPointer(threadID);
+    if (!moved) {
+        second->lowerBarrier();
+        first->lowerBarrier();
+        return ok;
+    }
+    other.lowerBarrier();
+
+    publishMoved(other, *this, moved, false);
+    for (ChangeFeed* f : feedsOf(other.feed, feed)) {
+        f->endUpdate(threadID);
+    }
+    other.retireList.waitForScans();
+    lowerBarrier();
+    wakeAllWaiters();
+    return true;
+}
+
+// A locked and validated window cannot be unlinked, so it stays safe after
+// its hazard slots are reset
+void MarkedList::lockWindow(int val, int threadID, Node*& pred, Node*& curr,
+                            std::unique_lock<std::mutex>& lockPred, std::unique_lock<std::mutex>& lockCurr) {
+    while (true) {
+        findWindow(val, threadID, pred, curr);
+        lockPred = std::unique_lock<std::mutex>(pred->m);
+        lockCurr = curr ? std::unique_lock<std::mutex>(curr->m) : std::unique_lock<std::mutex>();
+        if (validate(pred, curr)) {
+            break;
+        }
+        lockCurr = std::unique_lock<std::mutex>();
+        lockPred.unlock();
+    }
+    resetAccessedPointer(threadID);
+}
+
+// Both windows are locked, the list at the lower address first as in split
+// and splice. The node is not relinked: a reader still on it in 'from'
+// would follow its new next pointer into 'to'. Instead a copy is linked
+// into 'to' before the original is unlinked from 'from', so readers may
+// briefly find the key in both lists but never in neither.
+bool MarkedList::move(int val, MarkedList& from, MarkedList& to, int threadID) {
+    if (&from == &to) {
+        return from.contains(val, threadID);
+    }
+    MarkedList* first = std::min(&from, &to);
+    MarkedList* second = std::max(&from, &to);
+    first->beginUpdate(threadID);
+    second->beginUpdate(threadID);
+
+    Node* fromPred;
+    Node* fromCurr;
+    Node* toPred;
+    Node* toCurr;
+    std::unique_lock<std::mutex> lockFromPred, lockFromCurr, lockToPred, lockToCurr;
+    if (first == &from) {
+        from.lockWindow(val, threadID, fromPred, fromCurr, lockFromPred, lockFromCurr);
+        to.lockWindow(val, threadID, toPred, toCurr, lockToPred, lockToCurr);
+    } else {
+        to.lockWindow(val, threadID, toPred, toCurr, lockToPred, lockToCurr);
+        from.lockWindow(val, threadID, fromPred, fromCurr, lockFromPred, lockFromCurr);
+    }
+
+    bool found = (fromCurr && fromCurr->value == val);
+    if (found) {
+        if (to.feed) {
+            to.feed->beginUpdate(threadID);
+        }
+        toPred->next = new Node(val, toCurr);
+        if (to.feed) {
+            to.feed->publish(ChangeFeed::Op::Insert, val);
+            to.feed->endUpdate(threadID);
+        }
+        std::atomic_thread_fence(std::memory_order_release); // Linked before it is unlinked
+
+        if (from.feed) {
+            from.feed->beginUpdate(threadID);
+        }
+        fromCurr->removed = true;
+        fromPred->next = fromCurr->next;
+        if (from.feed) {
+            from.feed->publish(ChangeFeed::Op::Remove, val);
+            from.feed->endUpdate(threadID);
+        }
+    }
+    lockToCurr = std::unique_lock<std::mutex>();
+    lockToPred = std::unique_lock<std::mutex>();
+    lockFromCurr = std::unique_lock<std::mutex>();
+    lockFromPred = std::unique_lock<std::mutex>();
+
+    if (found) {
+        from.retireList.retire(fromCurr);
+        from.recordUpdates(-1, 1);
+        to.recordUpdates(1, 1);
+        to.wakeWaiters(val);
+    }
+    second->endUpdate(threadID);
+    first->endUpdate(threadID);
+    return found;
+}
+
+std::vector<MarkedList::Node*> MarkedList::lockSplitNodes() {
+    // Split nodes are locked in list order, as updates lock their windows.
+    // A locked live node cannot be unlinked, and nothing can be linked in
+    // front of it, so a walk from the previous bound always reaches it.
+    std::vector<Node*> bounds(1);
+    for (Node* node : samples) {
+        node->m.lock();
+        if (node->removed) {
+            node->m.unlock();
+            continue;
+        }
+        bounds.push_back(node);
+    }
+    bounds[0] = head->next;
+    bounds.push_back(nullptr);
+    return bounds;
+}
+
+void MarkedList::unlockSplitNodes(const std::vector<Node*>& bounds) {
+    for (size_t i = 1; i + 1 < bounds.size(); ++i) {
+        bounds[i]->m.unlock();
+    }
+}
+
+// Called with 'sampleMutex' held, and either under a ScanGuard or before
+// the picked nodes can be removed, so none of them is freed meanwhile
+void MarkedList::resample(const std::vector<std::vector<Node*>>& picked) {
+    for (Node* node : samples) {
+        node->sampled.store(false);
+    }
+    samples.clear();
+    for (const std::vector<Node*>& nodes : picked) {
+        for (Node* node : nodes) {
+            node->sampled.store(true);
+            samples.push_back(node);
+        }
+    }
+}
+
+long long MarkedList::parallelCount(ThreadPool& pool) {
+    return parallelReduce(pool, 0LL,
+                          [](long long acc, int) { return acc + 1; },
+                          [](long long a, long long b) { return a + b; });
+}
+
+long long MarkedList::parallelSum(ThreadPool& pool) {
+    return parallelReduce(pool, 0LL,
+                          [](long long acc, int key) { return acc + key; },
+                          [](long long a, long long b) { return a + b; });
+}
+
+bool MarkedList::parallelMinMax(ThreadPool& pool, int& min, int& max) {
+    struct Range {
+        bool empty;
+        int min;
+        int max;
+    };
+    Range range = parallelReduce(pool, Range{true, INT_MAX, INT_MIN},
+        [](Range acc, int key) { return Range{false, std::min(acc.min, key), std::max(acc.max, key)}; },
+        [](Range a, Range b) { return Range{a.empty && b.empty, std::min(a.min, b.min), std::max(a.max, b.max)}; });
+    min = range.min;
+    max = range.max;
+    return !range.empty;
+}
+
+bool MarkedList::parallelCheckList(ThreadPool& pool) {
+    struct Order {
+        bool empty;
+        bool sorted;
+        int first;
+        int last;
+    };
+    Order order = parallelReduce(pool, Order{true, true, 0, 0},
+        [](Order acc, int key) {
+            return acc.empty ? Order{false, true, key, key}
+                             : Order{false, acc.sorted && key >= acc.last, acc.first, key};
+        },
+        [](Order a, Order b) {
+            if (a.empty || b.empty) {
+                return a.empty ? b : a;
+            }
+            return Order{false, a.sorted && b.sorted && b.first >= a.last, a.first, b.last};
+        });
+    return order.sorted;
 }
 
 void MarkedList::printList() {
@@ -199,22 +1123,53 @@ void MarkedList::printList() {
     std::cout << std::endl;
 }
 
+std::vector<int> MarkedList::keys() {
+    RetireList<Node>::ScanGuard guard(retireList);
+    std::vector<int> out;
+    Node* curr = head->next;
+    while (curr) {
+        if (!curr->removed) {
+            out.push_back(curr->value);
+        }
+        curr = curr->next;
+    }
+    return out;
+}
+
+int MarkedList::rangeScan(int lo, int hi, std::vector<int>& out, int threadID, int limit) {
+    (void)threadID;
+    RetireList<Node>::ScanGuard guard(retireList);
+    int added = 0;
+    Node* curr = head->next;
+    while (curr && curr->value < lo) {
+        curr = curr->next;
+    }
+    while (curr && curr->value <= hi && added < limit) {
+        if (!curr->removed) {
+            out.push_back(curr->value);
+            added++;
+        }
+        curr = curr->next;
+    }
+    return added;
+}
+
 int MarkedList::get_length() {
     return length;
 }
 
 void MarkedList::printRetireList() {
-    for (Node* node : retireList) {
+    retireList.forEach([](Node* node) {
         std::cout << node->value << " ";
-    }
+    });
     std::cout << std::endl;
 }
 
 bool MarkedList::checkList() {
-    Node* prev = head;
+    Node* prev = nullptr; // The sentinel's dummy value takes no part in the order
     Node* curr = head->next;
     while (curr) {
-        if (curr->value < prev->value) {
+        if (prev && curr->value < prev->value) {
             return false;
         }
         prev = curr;
@@ -222,3 +1177,141 @@ bool MarkedList::checkList() {
     }
     return true;
 }
+
+MarkedList::Cursor::Cursor(MarkedList& list, int threadID)
+    : list(list), threadID(threadID), pred(list.head), relinks(0), current(INT_MIN), atEnd(false) {
+    seek(INT_MIN);
+}
+
+MarkedList::Cursor::~Cursor() {
+    AccessedPointers::clear(threadID, CURSOR_PTR_INDEX);
+}
+
+// Called once admitted, so no split or splice can run until the call ends.
+// One that ran since 'pred' was found may have moved it to another list.
+MarkedList::Node* MarkedList::Cursor::startFor(int val) {
+    if (relinks != list.relinks.load()) {
+        return nullptr;
+    }
+    return (pred == list.head || pred->value <= val) ? pred : nullptr;
+}
+
+void MarkedList::Cursor::settle(Node* newPred, Node* curr) {
+    AccessedPointers::store(threadID, newPred, CURSOR_PTR_INDEX);
+    pred = newPred;
+    relinks = list.relinks.load();
+    atEnd = (curr == nullptr);
+    if (curr) {
+        current = curr->value;
+    }
+    list.resetAccessedPointer(threadID);
+}
+
+bool MarkedList::Cursor::valid() {
+    return !atEnd;
+}
+
+int MarkedList::Cursor::key() {
+    return current;
+}
+
+bool MarkedList::Cursor::seek(int key) {
+    list.beginUpdate(threadID);
+    Node* start = startFor(key);
+    if (start != list.head && start && start->value == key) {
+        start = nullptr; // An equal key may sit at or before 'pred'
+    }
+    Node* p;
+    Node* c;
+    list.findWindow(key, threadID, p, c, start);
+    settle(p, c);
+    list.endUpdate(threadID);
+    return !atEnd;
+}
+
+bool MarkedList::Cursor::next() {
+    if (atEnd) {
+        return false;
+    }
+    list.beginUpdate(threadID);
+    Node* p;
+    Node* c;
+    int slot = list.findWindow(current, threadID, p, c, startFor(current));
+    if (c && c->value == current) {
+        list.findWindow(current, threadID, p, c, c, slot); // Step past the current node
+    }
+    settle(p, c);
+    list.endUpdate(threadID);
+    return !atEnd;
+}
+
+void MarkedList::Cursor::insert(int val) {
+    list.beginUpdate(threadID);
+    Node* start = startFor(val);
+    while (true) {
+        Node* p;
+        Node* c;
+        list.findWindow(val, threadID, p, c, start);
+        std::unique_lock<std::mutex> lockPred(p->m);
+        std::unique_lock<std::mutex> lockCurr;
+        if (c) {
+            lockCurr = std::unique_lock<std::mutex>(c->m);
+        }
+        if (!list.validate(p, c)) {
+            continue;
+        }
+
+        Node* newNode = new Node(val, c);
+        if (list.feed) {
+            list.feed->beginUpdate(threadID);
+        }
+        p->next = newNode;
+        if (list.feed) {
+            list.feed->publish(ChangeFeed::Op::Insert, val);
+            list.feed->endUpdate(threadID);
+        }
+        settle(p, newNode);
+        break;
+    }
+    list.wakeWaiters(val);
+    list.recordUpdates(1, 1);
+    list.endUpdate(threadID);
+}
+
+bool MarkedList::Cursor::remove() {
+    if (atEnd) {
+        return false;
+    }
+    list.beginUpdate(threadID);
+    while (true) {
+        Node* p;
+        Node* c;
+        list.findWindow(current, threadID, p, c, startFor(current));
+        if (!c || c->value != current) {
+            settle(p, c);
+            list.endUpdate(threadID);
+            return false;
+        }
+        std::unique_lock<std::mutex> lockPred(p->m);
+        std::unique_lock<std::mutex> lockCurr(c->m);
+        if (!list.validate(p, c)) {
+            continue;
+        }
+
+        if (list.feed) {
+            list.feed->beginUpdate(threadID);
+        }
+        c->removed = true;
+        p->next = c->next;
+        if (list.feed) {
+            list.feed->publish(ChangeFeed::Op::Remove, current);
+            list.feed->endUpdate(threadID);
+        }
+        list.retireList.retire(c);
+        settle(p, p->next); // 'p' is locked, so its new successor stays linked
+        break;
+    }
+    list.recordUpdates(-1, 1);
+    list.endUpdate(threadID);
+    return true;
+}
@@ -2,40 +2,98 @@
 #define CONCURRENT_LINKED_LIST_H
 
 #include <iostream>
+#include <algorithm>
+#include <memory>
 #include <mutex>
 #include <thread>
 #include <vector>
 #include <atomic>
+#include <chrono>
+#include <climits>
+#include <functional>
+#include <cstdint>
 
-#define MAX_THREADS 8
-#define ACCESSED_PTRS_PER_THREAD 2
+#include "reclamation.hpp"
+#include "thread-pool.hpp"
+
+#define PARALLEL_SCAN_SEGMENTS_PER_THREAD 4 // Split nodes kept per pool thread, for load balance
+#define BATCH_RANGES_PER_THREAD 4 // Key ranges per pool thread in applyBatch
+
+class ChangeFeed;
+class WaitTable;
 
 // ------------------------------------------------------
 // Optimistic (Lazy) Linked List with Marking
 // ------------------------------------------------------
 class MarkedList {
+public:
+    // Keys are counted as in a multiset: a union keeps the larger count of
+    // a key, an intersection the smaller, and a difference subtracts
+    enum class SetOp { Union, Intersection, Difference };
+
+    struct BatchOp {
+        enum class Type : uint8_t { Insert, Remove, Contains };
+        Type type;
+        int key;
+    };
+
+    class Cursor;
+
 private:
     struct Node {
         int value;
         Node* next;
         mutable std::mutex m; // Protects this node
         bool removed;         // 'true' if this node is logically removed
+        bool chunked;         // Allocated in one of 'chunks' rather than on its own
+        std::atomic<bool> sampled; // A split node for parallel scans; not reclaimed while set
 
-        Node(int val, Node* nxt = nullptr);
+        Node(int val, Node* nxt = nullptr, bool chunked = false);
     };
 
     Node* head; // Sentinel node: never removed
-    mutable std::mutex retireMutex;
-    std::vector<Node*> retireList; // Nodes waiting to be freed
+    std::vector<std::shared_ptr<unsigned char[]>> chunks; // Node storage from parallelBuild; shared after a split or splice
+    RetireList<Node> retireList; // Nodes waiting to be freed
     std::atomic<int> length;
     std::atomic<int> operationCounter;
+    ChangeFeed* feed; // Receives every insert and remove when set
+    std::mutex sampleMutex; // Held for a whole parallel scan
+    std::vector<Node*> samples; // Split nodes in list order, chosen during the last parallel scan
+
+    struct alignas(64) UpdaterSlot {
+        std::atomic<int> active; // Nesting depth of updates and open cursors
+    };
+    UpdaterSlot updaters[MAX_THREADS];
+    std::atomic<bool> barrier; // Raised by split and splice while they relink chains
+    std::atomic<uint64_t> relinks; // Bumped by split and splice; lock-free readers that see it change search again
+    std::atomic<WaitTable*> waits; // Created by the first waitFor
 
     bool validate(Node* pred, Node* curr); // Validate that 'pred->next == curr', and that both are not removed
+    // Protected traversal to the first node >= val, from head or from a live
+    // node 'start' <= val published in 'startSlot'; returns the slot of 'curr'
+    int findWindow(int val, int threadID, Node*& pred, Node*& curr, Node* start = nullptr,
+                   int startSlot = 1);
+    void lockWindow(int val, int threadID, Node*& pred, Node*& curr, std::unique_lock<std::mutex>& lockPred,
+                    std::unique_lock<std::mutex>& lockCurr); // findWindow, then lock and validate it
+    void insertSorted(const std::vector<int>& sortedKeys, int threadID); // Insert ascending keys in one pass
+    void recordUpdates(int lengthDelta, int count); // Length and reclamation bookkeeping for 'count' updates
+    bool publishChain(Node* first, int count); // Link a private sorted chain into this empty list
+    static void freeChain(Node* first);
+    static void releaseNode(Node* node);
+    std::vector<Node*> lockSplitNodes(); // Segment bounds: first node, live split nodes, then nullptr
+    void unlockSplitNodes(const std::vector<Node*>& bounds);
+    void resample(const std::vector<std::vector<Node*>>& picked);
+    void applySorted(const std::vector<BatchOp>& ops, const int* order, int count, uint8_t* results,
+                     int threadID);
+    void beginUpdate(int threadID); // Waits while a split or splice is relinking
+    void endUpdate(int threadID);
+    void raiseBarrier();
+    void lowerBarrier();
+    static int publishMoved(MarkedList& from, MarkedList& to, Node* moved, bool count);
+    void wakeWaiters(int val); // Called after linking 'val', once its locks are released
+    void wakeAllWaiters(); // After bulk loads, splits and splices
     void storeAccessedPointer(int threadID, Node* node, int index);
     void resetAccessedPointer(int threadID);
-    bool isNodeAccessed(Node* node);
-
-    static std::atomic<Node*> accessedPointers[MAX_THREADS][ACCESSED_PTRS_PER_THREAD];
 
 public:
     MarkedList();
@@ -44,13 +102,121 @@ public:
     void insert(int val, int threadID); // Insert 'val' in ascending order
     bool remove(int val, int threadID); // Remove 'val' if it exists
     bool contains(int val, int threadID); // Check if 'val' is in the list
+    bool waitFor(int val, std::chrono::nanoseconds timeout, int threadID); // Block until 'val' is in the list; false on timeout
+    int removeIf(const std::function<bool(int)>& pred, int threadID); // Remove every key matching 'pred' in one walk
+    int removeIf(int lo, int hi, const std::function<bool(int)>& pred, int threadID); // Same, for keys in [lo, hi]
+
+    // Apply 'ops' on 'pool', one traversal per key range. Pool threads use
+    // threadIDs firstThreadID .. firstThreadID + pool.size() - 1. results[i]
+    // is the outcome of ops[i] (1 for every insert); ops on one key take
+    // effect in their original order.
+    bool applyBatch(const std::vector<BatchOp>& ops, std::vector<uint8_t>& results, ThreadPool& pool,
+                    int firstThreadID);
 
     void scanAndReclaim(); // Scan and Reclaim Memory
+
+    void setChangeFeed(ChangeFeed* feed); // Set before the list is shared; bulk loads are not published
+    std::vector<int> snapshot(uint64_t& seq); // Live keys exactly as of change 'seq' of the attached feed
+
+    bool save(int fd); // Stream the live keys to 'fd' in the binary snapshot format
+    bool load(int fd); // Bulk load a snapshot from 'fd' into this empty list
+    bool bulkLoad(const std::vector<int>& sortedKeys); // Link ascending keys into this empty list in O(n)
+    bool parallelBuild(std::vector<int> keys, int numThreads); // Sort unsorted keys and link them into this empty list
     
+    void merge(MarkedList& other, SetOp op, const std::function<void(int)>& emit); // Stream 'this op other' in ascending order
+    bool mergeInto(MarkedList& other, SetOp op, MarkedList& result); // Bulk load 'this op other' into empty 'result'
+    void mergeFrom(MarkedList& other, int threadID); // In-place union: insert the keys 'other' has more of
+    bool split(int key, MarkedList& into, int threadID); // Move the keys >= key into empty 'into'
+    bool splice(MarkedList& other, int threadID); // Append all of 'other' if its keys all exceed ours
+    static bool move(int val, MarkedList& from, MarkedList& to, int threadID); // Move one 'val' so it is never in neither list
+
     void printList(); // Print the list contents in ascending order
+    std::vector<int> keys(); // Live keys in ascending order; like printList, not a consistent snapshot
+    int rangeScan(int lo, int hi, std::vector<int>& out, int threadID, int limit = INT_MAX); // Append up to 'limit' keys in [lo, hi]
     int get_length();
     void printRetireList();
     bool checkList();
+
+    // Fold the live keys on 'pool': each segment starts from 'identity' and
+    // applies map(acc, key) in order, then the segment results are folded
+    // left to right with combine(acc, part). The live split nodes are
+    // locked for the scan so segment bounds stay linked; 'map' must not
+    // update this list. Like keys(), not a consistent snapshot.
+    template <typename T, typename Map, typename Combine>
+    T parallelReduce(ThreadPool& pool, T identity, Map map, Combine combine) {
+        std::lock_guard<std::mutex> lock(sampleMutex);
+        RetireList<Node>::ScanGuard guard(retireList);
+        std::vector<Node*> bounds = lockSplitNodes();
+        int segments = (int)bounds.size() - 1;
+        int step = std::max(1, get_length() / (pool.size() * PARALLEL_SCAN_SEGMENTS_PER_THREAD));
+
+        // Every segment also picks evenly spaced split nodes for the next scan
+        std::vector<T> partial(segments, identity);
+        std::vector<std::vector<Node*>> picked(segments);
+        pool.parallelFor(segments, [&](int s, int) {
+            T acc = identity;
+            int seen = 0;
+            for (Node* curr = bounds[s]; curr != bounds[s + 1]; curr = curr->next) {
+                if (!curr->removed) {
+                    if (seen++ % step == 0) {
+                        picked[s].push_back(curr);
+                    }
+                    acc = map(acc, curr->value);
+                }
+            }
+            partial[s] = std::move(acc);
+        });
+        unlockSplitNodes(bounds);
+        resample(picked);
+
+        T result = identity;
+        for (T& part : partial) {
+            result = combine(result, part);
+        }
+        return result;
+    }
+
+    long long parallelCount(ThreadPool& pool);
+    long long parallelSum(ThreadPool& pool);
+    bool parallelMinMax(ThreadPool& pool, int& min, int& max); // false if the list is empty
+    bool parallelCheckList(ThreadPool& pool); // checkList over the live keys
+};
+
+// ------------------------------------------------------
+// Cursor: a position kept across nearby operations
+// ------------------------------------------------------
+// The cursor keeps the node before its current key published in the
+// thread's CURSOR_PTR_INDEX slot. Each operation finds its window again
+// from there and falls back to head only if that node was removed, so a
+// run of nearby updates costs about one traversal. Other calls by the same
+// thread, on the list or on any other container, may interleave. Each call
+// is admitted like an update, so split and splice wait only for a call in
+// progress; the call after one starts again from head. A thread has at
+// most one open cursor.
+class MarkedList::Cursor {
+public:
+    Cursor(MarkedList& list, int threadID); // Positioned on the smallest key
+    ~Cursor();
+    Cursor(const Cursor&) = delete;
+    Cursor& operator=(const Cursor&) = delete;
+
+    bool valid(); // Positioned on a key rather than past the end
+    int key(); // The current key, when valid()
+    bool seek(int key); // Move to the first key >= key; false if there is none
+    bool next(); // Move to the following key; false at the end
+    void insert(int val); // Insert 'val' and move onto it
+    bool remove(); // Remove the current key and move to the following one; false if it is gone
+
+private:
+    MarkedList& list;
+    int threadID;
+    Node* pred; // Last node before the current key
+    uint64_t relinks; // The list's relinks when 'pred' was found
+    int current;
+    bool atEnd;
+
+    Node* startFor(int val); // 'pred' if a search for 'val' can resume after it, else null for head
+    void settle(Node* newPred, Node* curr); // Called while 'newPred' and 'curr' are protected
 };
 
 #endif 
@@ -0,0 +1,290 @@
+#include "durable-list.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "serialization.hpp"
+
+#define CHECKPOINT_HEADER_SIZE 24
+
+// Make a new or renamed directory entry durable
+static bool syncDirectory(const std::string& path) {
+    size_t slash = path.rfind('/');
+    std::string dir = (slash == std::string::npos) ? "." : path.substr(0, slash + 1);
+    int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = (fsync(fd) == 0);
+    ::close(fd);
+    return ok;
+}
+
+DurableList::DurableList()
+    : firstSegment(0), segment(0), replayThreads(MAX_THREADS), barrier(false), checkpointing(false), checkpointOk(true) {
+    for (UpdaterSlot& slot : updaters) {
+        slot.active.store(false);
+    }
+}
+
+DurableList::~DurableList() {
+    close();
+}
+
+std::mutex& DurableList::stripeFor(int val) {
+    return stripes[(uint32_t)val % DURABLE_STRIPES];
+}
+
+std::string DurableList::segmentPath(uint64_t n) {
+    return basePath + ".wal." + std::to_string(n);
+}
+
+bool DurableList::readCheckpoint(std::vector<int>& keys, uint64_t& lsn, uint64_t& first) {
+    int fd = ::open((basePath + ".ckpt").c_str(), O_RDONLY);
+    if (fd < 0) {
+        return errno == ENOENT; // No checkpoint yet
+    }
+    uint8_t header[CHECKPOINT_HEADER_SIZE];
+    bool ok = readAll(fd, header, sizeof(header)) &&
+              std::memcmp(header, CHECKPOINT_MAGIC, 4) == 0 &&
+              getFixed(header + 20, 4) == crc32(header, 20);
+    if (ok) {
+        lsn = getFixed(header + 4, 8);
+        first = getFixed(header + 12, 8);
+        SnapshotReader reader(fd);
+        int key;
+        while (reader.next(key)) {
+            keys.push_back(key);
+        }
+        ok = reader.finish();
+    }
+    ::close(fd);
+    return ok;
+}
+
+bool DurableList::writeCheckpoint(const std::vector<int>& keys, uint64_t lsn, uint64_t first) {
+    std::string path = basePath + ".ckpt";
+    std::string temp = path + ".tmp";
+    int fd = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    uint8_t header[CHECKPOINT_HEADER_SIZE];
+    std::memcpy(header, CHECKPOINT_MAGIC, 4);
+    putFixed(header + 4, lsn, 8);
+    putFixed(header + 12, first, 8);
+    putFixed(header + 20, crc32(header, 20), 4);
+    bool ok = writeAll(fd, header, sizeof(header));
+    if (ok) {
+        SnapshotWriter writer(fd);
+        for (int key : keys) {
+            writer.add(key);
+        }
+        ok = writer.finish();
+    }
+    ok = ok && fdatasync(fd) == 0;
+    ::close(fd);
+
+    // The rename is the commit point: a crash before it keeps the old
+    // checkpoint and all the segments it needs
+    if (!ok || rename(temp.c_str(), path.c_str()) != 0 || !syncDirectory(path)) {
+        unlink(temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool DurableList::open(const std::string& path, int replayThreads) {
+    if (list.get_length() != 0 || !basePath.empty()) {
+        return false;
+    }
+    basePath = path;
+    this->replayThreads = replayThreads;
+
+    std::vector<int> base;
+    uint64_t checkpointLsn = 0;
+    firstSegment = 0;
+    if (!readCheckpoint(base, checkpointLsn, firstSegment)) {
+        basePath.clear();
+        return false;
+    }
+    // Segments a crashed checkpoint did not get to delete
+    for (uint64_t n = firstSegment; n > 0 && unlink(segmentPath(n - 1).c_str()) == 0; --n) {
+    }
+
+    // Read every full segment, then open the last one for appending
+    std::vector<WriteAheadLog::Record> records;
+    uint64_t lastLsn = checkpointLsn;
+    segment = firstSegment;
+    while (access(segmentPath(segment + 1).c_str(), F_OK) == 0) {
+        WriteAheadLog::read(segmentPath(segment), records);
+        segment++;
+    }
+    for (const WriteAheadLog::Record& record : records) {
+        lastLsn = std::max(lastLsn, record.lsn);
+    }
+    std::vector<WriteAheadLog::Record> tail;
+    if (!log.open(segmentPath(segment), &tail, lastLsn)) {
+        basePath.clear();
+        return false;
+    }
+    records.insert(records.end(), tail.begin(), tail.end());
+
+    // Records up to the checkpoint LSN are already in the checkpoint
+    std::vector<WriteAheadLog::Record> newer;
+    for (const WriteAheadLog::Record& record : records) {
+        if (record.lsn > checkpointLsn) {
+            newer.push_back(record);
+        }
+    }
+    if (!list.bulkLoad(WriteAheadLog::replay(newer, replayThreads, base))) {
+        log.close();
+        basePath.clear();
+        return false;
+    }
+    return true;
+}
+
+void DurableList::close() {
+    waitCheckpoint();
+    log.close();
+}
+
+// A thread announces itself before checking the barrier, and a checkpoint
+// raises the barrier before checking the announcements, so at least one
+// of them sees the other
+void DurableList::beginUpdate(int threadID) {
+    while (true) {
+        updaters[threadID].active.store(true);
+        if (!barrier.load()) {
+            return;
+        }
+        updaters[threadID].active.store(false);
+        std::unique_lock<std::mutex> lock(barrierMutex);
+        barrierCv.wait(lock, [&] { return !barrier.load(); });
+    }
+}
+
+void DurableList::endUpdate(int threadID) {
+    updaters[threadID].active.store(false, std::memory_order_release);
+}
+
+bool DurableList::insert(int val, int threadID, Durability mode) {
+    uint64_t lsn;
+    beginUpdate(threadID);
+    {
+        std::lock_guard<std::mutex> stripe(stripeFor(val));
+        list.insert(val, threadID);
+        lsn = log.append(threadID, WriteAheadLog::Op::Insert, val);
+    }
+    endUpdate(threadID);
+    return mode == Durability::Async || log.waitDurable(lsn);
+}
+
+bool DurableList::remove(int val, int threadID, Durability mode) {
+    uint64_t lsn;
+    beginUpdate(threadID);
+    {
+        std::lock_guard<std::mutex> stripe(stripeFor(val));
+        if (!list.remove(val, threadID)) {
+            endUpdate(threadID);
+            return false; // Nothing changed, so nothing to log
+        }
+        lsn = log.append(threadID, WriteAheadLog::Op::Remove, val);
+    }
+    endUpdate(threadID);
+    return mode == Durability::Async || log.waitDurable(lsn);
+}
+
+bool DurableList::contains(int val, int threadID) {
+    return list.contains(val, threadID);
+}
+
+bool DurableList::sync() {
+    return log.waitDurable(log.lastLsn());
+}
+
+bool DurableList::checkpoint() {
+    std::lock_guard<std::mutex> guard(checkpointMutex);
+    if (basePath.empty() || checkpointing.load()) {
+        return false;
+    }
+    if (checkpointer.joinable()) {
+        checkpointer.join();
+    }
+
+    // Hold off updates just long enough to move the log to a new segment,
+    // so the closed segments hold exactly the records up to 'lsn'
+    barrier.store(true);
+    for (UpdaterSlot& slot : updaters) {
+        while (slot.active.load()) {
+            std::this_thread::yield();
+        }
+    }
+    uint64_t lsn = log.lastLsn();
+    bool rotated = log.rotate(segmentPath(segment + 1));
+    if (rotated) {
+        segment++;
+    }
+    {
+        std::lock_guard<std::mutex> lock(barrierMutex);
+        barrier.store(false);
+    }
+    barrierCv.notify_all();
+    if (!rotated) {
+        return false;
+    }
+
+    checkpointing.store(true);
+    uint64_t first = segment;
+    checkpointer = std::thread([this, lsn, first]() {
+        bool ok = buildCheckpoint(lsn, first);
+        if (ok) {
+            for (; firstSegment < first; ++firstSegment) {
+                unlink(segmentPath(firstSegment).c_str());
+            }
+        }
+        checkpointOk = ok;
+        checkpointing.store(false);
+    });
+    return true;
+}
+
+// Rebuild the keys as of 'lsn' from the last checkpoint and the segments
+// before 'first', which the log closed at exactly that LSN
+bool DurableList::buildCheckpoint(uint64_t lsn, uint64_t first) {
+    std::vector<int> base;
+    uint64_t baseLsn = 0;
+    uint64_t baseFirst = 0;
+    if (!log.waitDurable(lsn) || !readCheckpoint(base, baseLsn, baseFirst)) {
+        return false;
+    }
+    std::vector<WriteAheadLog::Record> records;
+    for (uint64_t n = firstSegment; n < first; ++n) {
+        if (!WriteAheadLog::read(segmentPath(n), records)) {
+            return false;
+        }
+    }
+    std::vector<WriteAheadLog::Record> newer;
+    for (const WriteAheadLog::Record& record : records) {
+        if (record.lsn > baseLsn) {
+            newer.push_back(record);
+        }
+    }
+    return writeCheckpoint(WriteAheadLog::replay(newer, replayThreads, base), lsn, first);
+}
+
+bool DurableList::waitCheckpoint() {
+    std::lock_guard<std::mutex> guard(checkpointMutex);
+    if (checkpointer.joinable()) {
+        checkpointer.join();
+    }
+    return checkpointOk;
+}
+
+MarkedList& DurableList::get_list() {
+    return list;
+}
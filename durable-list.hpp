@@ -0,0 +1,93 @@
+#ifndef DURABLE_LIST_H
+#define DURABLE_LIST_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <cstdint>
+
+#include "concurrent-linked-list.hpp"
+#include "write-ahead-log.hpp"
+
+#define DURABLE_STRIPES 64 // Locks keeping list and log order the same per key
+#define CHECKPOINT_MAGIC "MCKP"
+
+// ------------------------------------------------------
+// MarkedList with a Write-Ahead Log
+// ------------------------------------------------------
+// Every successful update is applied to the list and appended to the log
+// under a per-key stripe lock, so both see updates to one key in the same
+// order. Async updates return at once and reach disk with the next group
+// commit; Durable updates return once their record is on disk. Other
+// threads may see an update before it is durable.
+//
+// For a list opened at 'path', the log lives in segments 'path.wal.N' and
+// the last checkpoint in 'path.ckpt':
+//   magic (4) | checkpoint LSN (8) | first live segment (8) | CRC-32 (4)
+// followed by the keys in the MarkedList::save snapshot format. open()
+// loads the checkpoint and replays the records after its LSN.
+//
+// checkpoint() holds off updates only while it notes the last LSN and
+// starts a new log segment, which takes constant time. A background thread
+// then rebuilds the keys as of that LSN from the previous checkpoint and
+// the closed segments, without reading the list. It writes the snapshot,
+// swaps it in with a rename and deletes the segments it covers.
+class DurableList {
+public:
+    enum class Durability { Async, Durable };
+
+    DurableList();
+    ~DurableList();
+
+    // Open or create the list stored at 'path' and rebuild it
+    bool open(const std::string& path, int replayThreads = MAX_THREADS);
+    void close(); // Finish any checkpoint and flush the log; the list stays readable
+
+    // A Durable update that returns false was applied to the list but
+    // could not be logged: the log failed and the update is lost on restart
+    bool insert(int val, int threadID, Durability mode = Durability::Async); // false only on log failure
+    bool remove(int val, int threadID, Durability mode = Durability::Async); // false if 'val' is absent or on log failure
+    bool contains(int val, int threadID);
+    bool sync(); // Wait until every update so far is durable; false if the log failed
+
+    bool checkpoint();     // Start a background checkpoint; false if one is already running
+    bool waitCheckpoint(); // Wait for the last checkpoint; false if it failed
+
+    MarkedList& get_list();
+
+private:
+    struct alignas(64) UpdaterSlot {
+        std::atomic<bool> active; // Set while the thread is inside an update
+    };
+
+    MarkedList list;
+    WriteAheadLog log;
+    std::mutex stripes[DURABLE_STRIPES];
+
+    std::string basePath;
+    uint64_t firstSegment; // Oldest segment not covered by a checkpoint
+    uint64_t segment;      // Segment receiving appends
+    int replayThreads;
+
+    UpdaterSlot updaters[MAX_THREADS];
+    std::atomic<bool> barrier; // Set while a checkpoint holds off updates
+    std::mutex barrierMutex;
+    std::condition_variable barrierCv;
+
+    std::mutex checkpointMutex; // Serializes checkpoint() and waitCheckpoint()
+    std::thread checkpointer;
+    std::atomic<bool> checkpointing;
+    bool checkpointOk;
+
+    std::mutex& stripeFor(int val);
+    void beginUpdate(int threadID);
+    void endUpdate(int threadID);
+    std::string segmentPath(uint64_t n);
+    bool readCheckpoint(std::vector<int>& keys, uint64_t& lsn, uint64_t& first);
+    bool writeCheckpoint(const std::vector<int>& keys, uint64_t lsn, uint64_t first);
+    bool buildCheckpoint(uint64_t lsn, uint64_t first);
+};
+
+#endif
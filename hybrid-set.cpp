@@ -0,0 +1,462 @@
+#include "hybrid-set.hpp"
+
+#include <algorithm>
+
+HybridSet::BitmapContainer::BitmapContainer() : Container(Kind::Bitmap) {
+    for (int i = 0; i < BITMAP_WORDS; ++i) {
+        words[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+HybridSet::ChainNode::ChainNode(uint16_t key, ChainNode* nxt) : key(key), removed(false), next(nxt) {}
+
+HybridSet::ListContainer::~ListContainer() {
+    ChainNode* node = first.load(std::memory_order_relaxed);
+    while (node) {
+        ChainNode* temp = node;
+        node = node->next.load(std::memory_order_relaxed);
+        delete temp;
+    }
+}
+
+HybridSet::Chunk::Chunk() : rep(new ListContainer()), cardinality(0) {}
+
+HybridSet::Leaf::Leaf() {
+    for (int i = 0; i < LEAF_SIZE; ++i) {
+        chunks[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+HybridSet::HybridSet() : length(0), operationCounter(0) {
+    for (int i = 0; i < DIRECTORY_SIZE; ++i) {
+        directory[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+HybridSet::~HybridSet() {
+    for (int i = 0; i < DIRECTORY_SIZE; ++i) {
+        Leaf* leaf = directory[i].load(std::memory_order_relaxed);
+        if (!leaf) {
+            continue;
+        }
+        for (int j = 0; j < LEAF_SIZE; ++j) {
+            Chunk* chunk = leaf->chunks[j].load(std::memory_order_relaxed);
+            if (chunk) {
+                delete chunk->rep.load(std::memory_order_relaxed);
+                delete chunk;
+            }
+        }
+        delete leaf;
+    }
+}
+
+// Flip the sign bit so that chunk order matches signed key order
+uint32_t HybridSet::chunkIndex(int val) {
+    return ((uint32_t)val ^ 0x80000000u) >> CHUNK_BITS;
+}
+
+uint16_t HybridSet::chunkOffset(int val) {
+    return (uint16_t)((uint32_t)val & (CHUNK_SIZE - 1));
+}
+
+int HybridSet::keyOf(uint32_t chunk, uint16_t offset) {
+    return (int)(((chunk << CHUNK_BITS) | offset) ^ 0x80000000u);
+}
+
+HybridSet::Chunk* HybridSet::findChunk(uint32_t index, bool create) {
+    std::atomic<Leaf*>& leafSlot = directory[index / LEAF_SIZE];
+    Leaf* leaf = leafSlot.load(std::memory_order_acquire);
+    if (!leaf) {
+        if (!create) {
+            return nullptr;
+        }
+        Leaf* fresh = new Leaf();
+        if (leafSlot.compare_exchange_strong(leaf, fresh, std::memory_order_acq_rel)) {
+            leaf = fresh;
+        } else {
+            delete fresh; // Another thread installed it first
+        }
+    }
+
+    std::atomic<Chunk*>& chunkSlot = leaf->chunks[index % LEAF_SIZE];
+    Chunk* chunk = chunkSlot.load(std::memory_order_acquire);
+    if (!chunk && create) {
+        Chunk* fresh = new Chunk();
+        if (chunkSlot.compare_exchange_strong(chunk, fresh, std::memory_order_acq_rel)) {
+            chunk = fresh;
+        } else {
+            delete fresh->rep.load(std::memory_order_relaxed);
+            delete fresh;
+        }
+    }
+    return chunk;
+}
+
+HybridSet::Container* HybridSet::protect(Chunk* chunk, int threadID) {
+    Container* rep = chunk->rep.load(std::memory_order_acquire);
+    while (true) {
+        AccessedPointers::store(threadID, rep, ENCLOSING_PTR_INDEX);
+        Container* again = chunk->rep.load(std::memory_order_acquire);
+        if (again == rep) {
+            return rep;
+        }
+        rep = again;
+    }
+}
+
+bool HybridSet::containerContains(Container* rep, uint16_t offset, int threadID) {
+    switch (rep->kind) {
+    case Kind::List:
+        return chainContains(static_cast<ListContainer*>(rep), offset, threadID);
+    case Kind::Array: {
+        const std::vector<uint16_t>& keys = static_cast<ArrayContainer*>(rep)->keys;
+        return std::binary_search(keys.begin(), keys.end(), offset);
+    }
+    case Kind::Bitmap: {
+        uint64_t word = static_cast<BitmapContainer*>(rep)->words[offset / 64].load(std::memory_order_acquire);
+        return (word >> (offset % 64)) & 1;
+    }
+    }
+    return false;
+}
+
+void HybridSet::containerKeys(Container* rep, std::vector<uint16_t>& out) {
+    switch (rep->kind) {
+    case Kind::List:
+        for (ChainNode* node = static_cast<ListContainer*>(rep)->first.load(std::memory_order_acquire); node;
+             node = node->next.load(std::memory_order_acquire)) {
+            out.push_back(node->key);
+        }
+        break;
+    case Kind::Array: {
+        const std::vector<uint16_t>& keys = static_cast<ArrayContainer*>(rep)->keys;
+        out.insert(out.end(), keys.begin(), keys.end());
+        break;
+    }
+    case Kind::Bitmap: {
+        BitmapContainer* bitmap = static_cast<BitmapContainer*>(rep);
+        for (int i = 0; i < BITMAP_WORDS; ++i) {
+            uint64_t word = bitmap->words[i].load(std::memory_order_relaxed);
+            while (word) {
+                int bit = __builtin_ctzll(word);
+                out.push_back((uint16_t)(i * 64 + bit));
+                word &= word - 1;
+            }
+        }
+        break;
+    }
+    }
+}
+
+// Publish each node before following it, then re-check that it is still
+// linked behind a live predecessor; otherwise restart. The container
+// itself is protected by the caller.
+bool HybridSet::chainContains(ListContainer* list, uint16_t offset, int threadID) {
+    while (true) {
+        int slot = 0;
+        ChainNode* curr = list->first.load(std::memory_order_acquire);
+        AccessedPointers::store(threadID, curr, slot);
+        if (list->first.load(std::memory_order_acquire) != curr) {
+            continue;
+        }
+
+        bool restart = false;
+        while (curr && curr->key < offset) {
+            ChainNode* next = curr->next.load(std::memory_order_acquire);
+            slot = 1 - slot;
+            AccessedPointers::store(threadID, next, slot);
+            if (curr->removed.load(std::memory_order_acquire) || curr->next.load(std::memory_order_acquire) != next) {
+                restart = true;
+                break;
+            }
+            curr = next;
+        }
+
+        if (!restart) {
+            bool found = (curr && curr->key == offset);
+            AccessedPointers::reset(threadID);
+            return found;
+        }
+    }
+}
+
+bool HybridSet::chainInsert(ListContainer* list, uint16_t offset) {
+    std::atomic<ChainNode*>* link = &list->first;
+    ChainNode* curr = link->load(std::memory_order_relaxed);
+    while (curr && curr->key < offset) {
+        link = &curr->next;
+        curr = link->load(std::memory_order_relaxed);
+    }
+    if (curr && curr->key == offset) {
+        return false;
+    }
+    link->store(new ChainNode(offset, curr), std::memory_order_release);
+    return true;
+}
+
+bool HybridSet::chainRemove(ListContainer* list, uint16_t offset) {
+    std::atomic<ChainNode*>* link = &list->first;
+    ChainNode* curr = link->load(std::memory_order_relaxed);
+    while (curr && curr->key < offset) {
+        link = &curr->next;
+        curr = link->load(std::memory_order_relaxed);
+    }
+    if (!curr || curr->key != offset) {
+        return false;
+    }
+    curr->removed.store(true, std::memory_order_release);
+    link->store(curr->next.load(std::memory_order_relaxed), std::memory_order_release);
+    nodeRetireList.retire(curr);
+    return true;
+}
+
+// Swap in a new container for 'chunk' (whose mutex is held) and retire the old one
+void HybridSet::publish(Chunk* chunk, Container* rep) {
+    Container* old = chunk->rep.load(std::memory_order_relaxed);
+    chunk->rep.store(rep, std::memory_order_release);
+    retireList.retire(old);
+}
+
+void HybridSet::convertIfNeeded(Chunk* chunk) {
+    Container* rep = chunk->rep.load(std::memory_order_relaxed);
+    int card = chunk->cardinality;
+
+    Kind target = rep->kind;
+    if (rep->kind == Kind::List && card > LIST_MAX) {
+        target = Kind::Array;
+    } else if (rep->kind == Kind::Array && card > ARRAY_MAX) {
+        target = Kind::Bitmap;
+    } else if (rep->kind == Kind::Array && card < LIST_MAX / 2) {
+        target = Kind::List;
+    } else if (rep->kind == Kind::Bitmap && card < ARRAY_MAX / 2) {
+        target = Kind::Array;
+    }
+    if (target == rep->kind) {
+        return;
+    }
+
+    std::vector<uint16_t> keys;
+    keys.reserve(card);
+    containerKeys(rep, keys);
+
+    Container* converted = nullptr;
+    if (target == Kind::List) {
+        // Linked back to front before the container is published
+        ListContainer* list = new ListContainer();
+        ChainNode* first = nullptr;
+        for (auto it = keys.rbegin(); it != keys.rend(); ++it) {
+            first = new ChainNode(*it, first);
+        }
+        list->first.store(first, std::memory_order_relaxed);
+        converted = list;
+    } else if (target == Kind::Array) {
+        ArrayContainer* array = new ArrayContainer();
+        array->keys = std::move(keys);
+        converted = array;
+    } else {
+        BitmapContainer* bitmap = new BitmapContainer();
+        for (uint16_t key : keys) {
+            bitmap->words[key / 64].fetch_or(1ull << (key % 64), std::memory_order_relaxed);
+        }
+        converted = bitmap;
+    }
+    publish(chunk, converted);
+}
+
+void HybridSet::countOperation() {
+    if (operationCounter.fetch_add(1, std::memory_order_relaxed) + 1 >= length) {
+        scanAndReclaim();
+        operationCounter.fetch_sub(length, std::memory_order_relaxed);
+    }
+}
+
+void HybridSet::scanAndReclaim() {
+    nodeRetireList.scanAndReclaim();
+    retireList.scanAndReclaim();
+}
+
+bool HybridSet::insert(int val, int threadID) {
+    (void)threadID; // Writers hold the chunk lock and need no hazard slots
+    Chunk* chunk = findChunk(chunkIndex(val), true);
+    uint16_t offset = chunkOffset(val);
+    bool added = false;
+    {
+        std::lock_guard<std::mutex> lock(chunk->m);
+        Container* rep = chunk->rep.load(std::memory_order_relaxed);
+
+        switch (rep->kind) {
+        case Kind::List:
+            added = chainInsert(static_cast<ListContainer*>(rep), offset);
+            break;
+        case Kind::Array: {
+            // Copy-on-write so that readers search an immutable array
+            const std::vector<uint16_t>& keys = static_cast<ArrayContainer*>(rep)->keys;
+            auto pos = std::lower_bound(keys.begin(), keys.end(), offset);
+            if (pos == keys.end() || *pos != offset) {
+                ArrayContainer* copy = new ArrayContainer();
+                copy->keys.reserve(keys.size() + 1);
+                copy->keys.insert(copy->keys.end(), keys.begin(), pos);
+                copy->keys.push_back(offset);
+                copy->keys.insert(copy->keys.end(), pos, keys.end());
+                publish(chunk, copy);
+                added = true;
+            }
+            break;
+        }
+        case Kind::Bitmap: {
+            uint64_t bit = 1ull << (offset % 64);
+            uint64_t old = static_cast<BitmapContainer*>(rep)->words[offset / 64].fetch_or(bit, std::memory_order_release);
+            added = !(old & bit);
+            break;
+        }
+        }
+
+        if (added) {
+            chunk->cardinality++;
+            convertIfNeeded(chunk);
+        }
+    }
+
+    if (added) {
+        length.fetch_add(1, std::memory_order_relaxed);
+        countOperation();
+    }
+    return added;
+}
+
+bool HybridSet::remove(int val, int threadID) {
+    (void)threadID; // Writers hold the chunk lock and need no hazard slots
+    Chunk* chunk = findChunk(chunkIndex(val), false);
+    if (!chunk) {
+        return false;
+    }
+    uint16_t offset = chunkOffset(val);
+    bool removed = false;
+    {
+        std::lock_guard<std::mutex> lock(chunk->m);
+        Container* rep = chunk->rep.load(std::memory_order_relaxed);
+
+        switch (rep->kind) {
+        case Kind::List:
+            removed = chainRemove(static_cast<ListContainer*>(rep), offset);
+            break;
+        case Kind::Array: {
+            const std::vector<uint16_t>& keys = static_cast<ArrayContainer*>(rep)->keys;
+            auto pos = std::lower_bound(keys.begin(), keys.end(), offset);
+            if (pos != keys.end() && *pos == offset) {
+                ArrayContainer* copy = new ArrayContainer();
+                copy->keys.reserve(keys.size() - 1);
+                copy->keys.insert(copy->keys.end(), keys.begin(), pos);
+                copy->keys.insert(copy->keys.end(), pos + 1, keys.end());
+                publish(chunk, copy);
+                removed = true;
+            }
+            break;
+        }
+        case Kind::Bitmap: {
+            uint64_t bit = 1ull << (offset % 64);
+            uint64_t old = static_cast<BitmapContainer*>(rep)->words[offset / 64].fetch_and(~bit, std::memory_order_release);
+            removed = (old & bit) != 0;
+            break;
+        }
+        }
+
+        if (removed) {
+            chunk->cardinality--;
+            convertIfNeeded(chunk);
+        }
+    }
+
+    if (removed) {
+        length.fetch_sub(1, std::memory_order_relaxed);
+        countOperation();
+    }
+    return removed;
+}
+
+bool HybridSet::contains(int val, int threadID) {
+    Chunk* chunk = findChunk(chunkIndex(val), false);
+    if (!chunk) {
+        return false;
+    }
+
+    Container* rep = protect(chunk, threadID);
+    bool found = containerContains(rep, chunkOffset(val), threadID);
+    AccessedPointers::clear(threadID, ENCLOSING_PTR_INDEX);
+    return found;
+}
+
+void HybridSet::printList() {
+    for (uint32_t i = 0; i < DIRECTORY_SIZE * LEAF_SIZE; ++i) {
+        Leaf* leaf = directory[i / LEAF_SIZE].load(std::memory_order_acquire);
+        if (!leaf) {
+            i += LEAF_SIZE - 1;
+            continue;
+        }
+        Chunk* chunk = leaf->chunks[i % LEAF_SIZE].load(std::memory_order_acquire);
+        if (!chunk) {
+            continue;
+        }
+        std::lock_guard<std::mutex> lock(chunk->m);
+        std::vector<uint16_t> keys;
+        containerKeys(chunk->rep.load(std::memory_order_relaxed), keys);
+        for (uint16_t key : keys) {
+            std::cout << keyOf(i, key) << " ";
+        }
+    }
+    std::cout << std::endl;
+}
+
+void HybridSet::printContainers() {
+    static const char* names[] = {"list", "array", "bitmap"};
+    for (uint32_t i = 0; i < DIRECTORY_SIZE * LEAF_SIZE; ++i) {
+        Leaf* leaf = directory[i / LEAF_SIZE].load(std::memory_order_acquire);
+        if (!leaf) {
+            i += LEAF_SIZE - 1;
+            continue;
+        }
+        Chunk* chunk = leaf->chunks[i % LEAF_SIZE].load(std::memory_order_acquire);
+        if (!chunk) {
+            continue;
+        }
+        std::lock_guard<std::mutex> lock(chunk->m);
+        Container* rep = chunk->rep.load(std::memory_order_relaxed);
+        std::cout << "[" << keyOf(i, 0) << ", " << keyOf(i, CHUNK_SIZE - 1) << "]: "
+                  << names[(int)rep->kind] << " (" << chunk->cardinality << " keys)" << std::endl;
+    }
+}
+
+int HybridSet::get_length() {
+    return length;
+}
+
+// Check that every chunk is sorted, matches its cardinality and uses the
+// container its density calls for (allowing for hysteresis)
+bool HybridSet::checkList() {
+    for (int i = 0; i < DIRECTORY_SIZE; ++i) {
+        Leaf* leaf = directory[i].load(std::memory_order_acquire);
+        if (!leaf) {
+            continue;
+        }
+        for (int j = 0; j < LEAF_SIZE; ++j) {
+            Chunk* chunk = leaf->chunks[j].load(std::memory_order_acquire);
+            if (!chunk) {
+                continue;
+            }
+            std::lock_guard<std::mutex> lock(chunk->m);
+            Container* rep = chunk->rep.load(std::memory_order_relaxed);
+            std::vector<uint16_t> keys;
+            containerKeys(rep, keys);
+            if ((int)keys.size() != chunk->cardinality || !std::is_sorted(keys.begin(), keys.end()) ||
+                std::adjacent_find(keys.begin(), keys.end()) != keys.end()) {
+                return false;
+            }
+            if ((rep->kind == Kind::List && chunk->cardinality > LIST_MAX) ||
+                (rep->kind == Kind::Array && chunk->cardinality > ARRAY_MAX) ||
+                (rep->kind == Kind::Bitmap && chunk->cardinality < ARRAY_MAX / 2)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,116 @@
+#ifndef HYBRID_SET_H
+#define HYBRID_SET_H
+
+#include <iostream>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <cstdint>
+
+#include "reclamation.hpp"
+
+#define CHUNK_BITS 16
+#define CHUNK_SIZE (1 << CHUNK_BITS)
+#define DIRECTORY_SIZE 256 // Chunks are found through a two-level directory
+#define LEAF_SIZE 256
+#define BITMAP_WORDS (CHUNK_SIZE / 64)
+#define LIST_MAX 32     // A sparse chunk becomes an array above this many keys
+#define ARRAY_MAX 4096  // An array chunk becomes a bitmap above this many keys
+
+// ------------------------------------------------------
+// Adaptive Hybrid Set (Roaring-style chunks)
+// ------------------------------------------------------
+// The key space is split into chunks of CHUNK_SIZE keys. Each chunk picks
+// the cheapest container for its density: a chain of 16-byte nodes while
+// sparse, a sorted array of 16-bit offsets, or a bitmap once dense.
+// Writers to a chunk are serialized by its mutex; readers are lock-free
+// and protect the container they search with ENCLOSING_PTR_INDEX, and a
+// chain's nodes with the two traversal slots. Conversions go the other
+// way at half the threshold so a chunk does not flip back and forth.
+class HybridSet {
+private:
+    enum class Kind { List, Array, Bitmap };
+
+    struct Container {
+        const Kind kind;
+        explicit Container(Kind kind) : kind(kind) {}
+        virtual ~Container() {}
+    };
+
+    // Only the chunk's writer links and unlinks nodes, so a node needs no
+    // lock; readers validate each step like MarkedList::findWindow
+    struct ChainNode {
+        uint16_t key;
+        std::atomic<bool> removed;
+        std::atomic<ChainNode*> next;
+
+        ChainNode(uint16_t key, ChainNode* nxt);
+    };
+
+    struct ListContainer : Container {
+        std::atomic<ChainNode*> first;
+        ListContainer() : Container(Kind::List), first(nullptr) {}
+        ~ListContainer(); // Frees the nodes still linked; unlinked ones are in 'nodeRetireList'
+    };
+
+    struct ArrayContainer : Container {
+        std::vector<uint16_t> keys; // Sorted; replaced, never modified, once published
+        ArrayContainer() : Container(Kind::Array) {}
+    };
+
+    struct BitmapContainer : Container {
+        std::atomic<uint64_t> words[BITMAP_WORDS];
+        BitmapContainer();
+    };
+
+    struct Chunk {
+        std::mutex m; // Serializes writers and conversions
+        std::atomic<Container*> rep;
+        int cardinality; // Protected by 'm'
+
+        Chunk();
+    };
+
+    struct Leaf {
+        std::atomic<Chunk*> chunks[LEAF_SIZE];
+        Leaf();
+    };
+
+    std::atomic<Leaf*> directory[DIRECTORY_SIZE];
+    RetireList<Container> retireList; // Replaced containers waiting to be freed
+    RetireList<ChainNode> nodeRetireList; // Nodes removed from list containers
+    std::atomic<int> length;
+    std::atomic<int> operationCounter;
+
+    static uint32_t chunkIndex(int val);
+    static uint16_t chunkOffset(int val);
+    static int keyOf(uint32_t chunk, uint16_t offset);
+
+    Chunk* findChunk(uint32_t index, bool create);
+    Container* protect(Chunk* chunk, int threadID);
+    bool containerContains(Container* rep, uint16_t offset, int threadID);
+    bool chainContains(ListContainer* list, uint16_t offset, int threadID);
+    bool chainInsert(ListContainer* list, uint16_t offset); // Called by the chunk's writer
+    bool chainRemove(ListContainer* list, uint16_t offset);
+    void containerKeys(Container* rep, std::vector<uint16_t>& out);
+    void publish(Chunk* chunk, Container* rep);
+    void convertIfNeeded(Chunk* chunk);
+    void countOperation();
+
+public:
+    HybridSet();
+    ~HybridSet();
+
+    bool insert(int val, int threadID); // Insert 'val'; false if already present
+    bool remove(int val, int threadID); // Remove 'val' if it exists
+    bool contains(int val, int threadID); // Check if 'val' is in the set
+
+    void scanAndReclaim(); // Scan and Reclaim Memory
+
+    void printList(); // Print the set contents in ascending order
+    void printContainers(); // Print the container kind and size of each chunk
+    int get_length();
+    bool checkList();
+};
+
+#endif
@@ -0,0 +1,130 @@
+#ifndef LAZY_LIST_H
+#define LAZY_LIST_H
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+
+#include "reclamation.hpp"
+
+// ------------------------------------------------------
+// Lazy List Core
+// ------------------------------------------------------
+// The traversal, window locking and reclamation bookkeeping of the lazy
+// list, for containers whose nodes differ only in what they store. A Node
+// has 'next', a mutex 'm' and a 'removed' flag. Compare is a function
+// object with compare(node, key) and compare(node, node), each returning
+// <0, 0 or >0 as the node's key is less than, equal to or greater than
+// the other. The container creates the nodes, including the sentinel
+// head, and 'release' frees them.
+template <typename Node, typename Key, typename Compare>
+class LazyList {
+public:
+    Node* head; // Sentinel node: never removed or compared
+    RetireList<Node> retireList; // Nodes waiting to be freed
+    std::atomic<int> length;
+
+    explicit LazyList(Node* head, std::function<void(Node*)> release = [](Node* node) { delete node; })
+        : head(head), retireList(release), length(0), operationCounter(0), release(release) {}
+
+    ~LazyList() {
+        Node* curr = head;
+        while (curr) {
+            Node* temp = curr;
+            curr = curr->next;
+            release(temp);
+        }
+    }
+
+    LazyList(const LazyList&) = delete;
+    LazyList& operator=(const LazyList&) = delete;
+
+    // Validate that 'pred->next == curr', and that both are not removed
+    static bool validate(Node* pred, Node* curr) {
+        return (!pred->removed && !(curr && curr->removed) && pred->next == curr);
+    }
+
+    // 'curr' is the first node >= key; both stay published in slots 0/1
+    void findWindow(const Key& key, int threadID, Node*& pred, Node*& curr) {
+        while (true) {
+            // Publish each node before following it, then re-check that it is
+            // still linked behind a live predecessor; otherwise restart.
+            int slot = 0;
+            pred = head;
+            curr = pred->next;
+            AccessedPointers::store(threadID, curr, slot);
+            if (pred->next != curr) {
+                continue;
+            }
+
+            bool restart = false;
+            while (curr && compare(curr, key) < 0) {
+                Node* next = curr->next;
+                slot = 1 - slot;
+                AccessedPointers::store(threadID, next, slot);
+                if (curr->removed || curr->next != next) {
+                    restart = true;
+                    break;
+                }
+                pred = curr;
+                curr = next;
+            }
+
+            if (!restart) {
+                return;
+            }
+        }
+    }
+
+    // findWindow, then lock and validate the window. A locked and validated
+    // window cannot be unlinked, so it stays safe after the hazard slots
+    // are reset.
+    void lockWindow(const Key& key, int threadID, Node*& pred, Node*& curr,
+                    std::unique_lock<std::mutex>& lockPred, std::unique_lock<std::mutex>& lockCurr) {
+        while (true) {
+            findWindow(key, threadID, pred, curr);
+            lockPred = std::unique_lock<std::mutex>(pred->m);
+            lockCurr = curr ? std::unique_lock<std::mutex>(curr->m) : std::unique_lock<std::mutex>();
+            if (validate(pred, curr)) {
+                break;
+            }
+            lockCurr = std::unique_lock<std::mutex>();
+            lockPred.unlock();
+        }
+        AccessedPointers::reset(threadID);
+    }
+
+    // Length and reclamation bookkeeping after an update that linked or
+    // unlinked a node, once its locks are released
+    void recordUpdate(int lengthDelta) {
+        length.fetch_add(lengthDelta, std::memory_order_relaxed);
+        if (operationCounter.fetch_add(1, std::memory_order_relaxed) + 1 >= length) {
+            scanAndReclaim();
+            operationCounter.fetch_sub(length, std::memory_order_relaxed);
+        }
+    }
+
+    void scanAndReclaim() {
+        retireList.scanAndReclaim();
+    }
+
+    bool checkList() {
+        Node* prev = nullptr;
+        Node* curr = head->next;
+        while (curr) {
+            if (prev && compare(prev, curr) >= 0) {
+                return false;
+            }
+            prev = curr;
+            curr = curr->next;
+        }
+        return true;
+    }
+
+private:
+    std::atomic<int> operationCounter;
+    std::function<void(Node*)> release;
+    Compare compare;
+};
+
+#endif
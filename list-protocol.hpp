@@ -0,0 +1,46 @@
+#ifndef LIST_PROTOCOL_H
+#define LIST_PROTOCOL_H
+
+#include <cstdint>
+
+// ------------------------------------------------------
+// List Server Wire Protocol
+// ------------------------------------------------------
+// Clients talk to list-server over a Unix stream socket. Every frame, in
+// either direction, starts with a 12-byte little-endian header:
+//   payload length (4) | request id (4) | opcode or status (1) | reserved (3)
+// Requests may be pipelined: a client can send any number of frames
+// without waiting, and responses come back in request order carrying the
+// request id. Keys are signed 32-bit integers.
+//
+//   Request                              Response payload
+//   OP_INSERT   count (4) | keys (4 each) count (4)
+//   OP_REMOVE   count (4) | keys          count (4) | one result byte per key
+//   OP_CONTAINS count (4) | keys          count (4) | one result byte per key
+//   OP_RANGE    lo (4) | hi (4) | limit (4) count (4) | keys in [lo, hi], ascending
+//
+// OP_RANGE returns at most min(limit, PROTOCOL_MAX_RANGE) keys; a client
+// pages through a larger range by repeating it from the last key + 1.
+//   OP_LENGTH   (empty)                   length (4)
+//
+// A malformed request gets STATUS_BAD_REQUEST and an empty payload; a
+// frame over PROTOCOL_MAX_PAYLOAD closes the connection.
+#define PROTOCOL_HEADER_SIZE 12
+#define PROTOCOL_MAX_PAYLOAD (16u << 20)
+#define PROTOCOL_MAX_RANGE 65536 // Keys in one OP_RANGE response
+#define PROTOCOL_DEFAULT_SOCKET "/tmp/marked-list.sock"
+
+enum ProtocolOp : uint8_t {
+    OP_INSERT = 1,
+    OP_REMOVE = 2,
+    OP_CONTAINS = 3,
+    OP_RANGE = 4,
+    OP_LENGTH = 5,
+};
+
+enum ProtocolStatus : uint8_t {
+    STATUS_OK = 0,
+    STATUS_BAD_REQUEST = 1,
+};
+
+#endif
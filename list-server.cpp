@@ -0,0 +1,363 @@
+#include <iostream>
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <string>
+#include <mutex>
+#include <unordered_set>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "concurrent-linked-list.hpp"
+#include "list-protocol.hpp"
+#include "thread-pool.hpp"
+#include "serialization.hpp"
+
+// ------------------------------------------------------
+// List Server: a MarkedList behind a Unix socket
+// ------------------------------------------------------
+// Usage: ./server [socketPath] [workers]
+// The main thread accepts connections and hands each one to a worker in
+// turn. Every worker runs its own epoll loop and owns its connections, so
+// a connection's requests are executed and answered in order by one
+// thread, whose index is its threadID for the list. See list-protocol.hpp
+// for the wire format.
+
+#define SERVER_EPOLL_EVENTS 64
+#define SERVER_POLL_MS 200 // How often idle loops notice a shutdown request
+#define SERVER_READ_CHUNK (64 * 1024)
+#define SERVER_READ_CHUNKS 16 // Per wake-up, so one busy client cannot starve the others
+#define SERVER_MAX_BACKLOG (4u << 20) // Unsent response bytes at which a connection's requests wait
+
+static std::atomic<bool> stopping(false);
+
+static void onSignal(int) {
+    stopping.store(true);
+}
+
+struct Connection {
+    int fd;
+    std::vector<uint8_t> in;
+    std::vector<uint8_t> out;
+    size_t outPos;
+    bool eof; // The client has stopped sending; close once the responses are out
+
+    explicit Connection(int fd) : fd(fd), outPos(0), eof(false) {}
+
+    size_t backlog() const { return out.size() - outPos; }
+};
+
+class Worker {
+public:
+    // Batches run on a pool of just the calling worker, under its threadID
+    Worker(MarkedList& list, int threadID) : list(list), threadID(threadID), pool(1) {
+        epfd = epoll_create1(EPOLL_CLOEXEC);
+    }
+
+    // Only once run() has returned
+    ~Worker() {
+        for (Connection* conn : connections) {
+            ::close(conn->fd);
+            delete conn;
+        }
+        ::close(epfd);
+    }
+
+    bool add(int fd) {
+        Connection* conn = new Connection(fd);
+        std::lock_guard<std::mutex> lock(connectionsMutex);
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.ptr = conn;
+        if (epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            ::close(fd);
+            delete conn;
+            return false;
+        }
+        connections.insert(conn);
+        return true;
+    }
+
+    void run() {
+        epoll_event events[SERVER_EPOLL_EVENTS];
+        while (!stopping.load()) {
+            int n = epoll_wait(epfd, events, SERVER_EPOLL_EVENTS, SERVER_POLL_MS);
+            for (int i = 0; i < n; ++i) {
+                Connection* conn = static_cast<Connection*>(events[i].data.ptr);
+                if (!handle(*conn, events[i].events)) {
+                    epoll_ctl(epfd, EPOLL_CTL_DEL, conn->fd, nullptr);
+                    ::close(conn->fd);
+                    std::lock_guard<std::mutex> lock(connectionsMutex);
+                    connections.erase(conn);
+                    delete conn;
+                }
+            }
+        }
+    }
+
+private:
+    MarkedList& list;
+    int threadID;
+    int epfd;
+    ThreadPool pool;
+    std::mutex connectionsMutex; // add() runs on the accepting thread
+    std::unordered_set<Connection*> connections;
+    std::vector<MarkedList::BatchOp> ops;
+    std::vector<uint8_t> results;
+
+    // Returns false once the connection should be closed
+    bool handle(Connection& conn, uint32_t events) {
+        // A connection with a backlog is not read, so its input stays bounded
+        if ((events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) && conn.backlog() < SERVER_MAX_BACKLOG &&
+            !readInput(conn)) {
+            return false;
+        }
+        // Requests held back by the backlog resume as writes drain it
+        do {
+            if (!executeFrames(conn) || !writeResponses(conn)) {
+                return false;
+            }
+        } while (conn.backlog() < SERVER_MAX_BACKLOG && hasFrame(conn));
+        return !(conn.eof && conn.backlog() == 0 && !hasFrame(conn));
+    }
+
+    bool readInput(Connection& conn) {
+        for (int chunk = 0; chunk < SERVER_READ_CHUNKS && !conn.eof; ++chunk) {
+            size_t used = conn.in.size();
+            conn.in.resize(used + SERVER_READ_CHUNK);
+            ssize_t n = ::read(conn.fd, conn.in.data() + used, SERVER_READ_CHUNK);
+            conn.in.resize(used + std::max<ssize_t>(n, 0));
+            if (n > 0) {
+                continue;
+            }
+            if (n < 0 && errno == EINTR) {
+                chunk--;
+                continue;
+            }
+            conn.eof = (n == 0);
+            return conn.eof || errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        return true;
+    }
+
+    static bool hasFrame(const Connection& conn) {
+        return conn.in.size() >= PROTOCOL_HEADER_SIZE &&
+               conn.in.size() - PROTOCOL_HEADER_SIZE >= getFixed(conn.in.data(), 4);
+    }
+
+    // Execute complete frames until the input runs out or the backlog is full
+    bool executeFrames(Connection& conn) {
+        size_t pos = 0;
+        while (conn.in.size() - pos >= PROTOCOL_HEADER_SIZE && conn.backlog() < SERVER_MAX_BACKLOG) {
+            const uint8_t* frame = conn.in.data() + pos;
+            uint32_t len = (uint32_t)getFixed(frame, 4);
+            if (len > PROTOCOL_MAX_PAYLOAD) {
+                return false;
+            }
+            if (conn.in.size() - pos < PROTOCOL_HEADER_SIZE + len) {
+                break;
+            }
+            execute(frame[8], (uint32_t)getFixed(frame + 4, 4), frame + PROTOCOL_HEADER_SIZE, len,
+                    conn.out);
+            pos += PROTOCOL_HEADER_SIZE + len;
+        }
+        conn.in.erase(conn.in.begin(), conn.in.begin() + pos);
+        return true;
+    }
+
+    bool writeResponses(Connection& conn) {
+        while (conn.outPos < conn.out.size()) {
+            ssize_t n = ::write(conn.fd, conn.out.data() + conn.outPos, conn.out.size() - conn.outPos);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            }
+            if (n <= 0) {
+                return false;
+            }
+            conn.outPos += n;
+        }
+        if (conn.outPos == conn.out.size()) {
+            conn.out.clear();
+            conn.outPos = 0;
+        } else if (conn.outPos >= conn.out.size() / 2) {
+            conn.out.erase(conn.out.begin(), conn.out.begin() + conn.outPos);
+            conn.outPos = 0;
+        }
+
+        // Only wait for the socket to drain while the client is behind or has stopped sending
+        epoll_event ev{};
+        bool pending = conn.backlog() > 0;
+        ev.events = (conn.eof || conn.backlog() >= SERVER_MAX_BACKLOG)
+                        ? (uint32_t)EPOLLOUT
+                        : (uint32_t)EPOLLIN | (uint32_t)EPOLLRDHUP | (pending ? (uint32_t)EPOLLOUT : 0u);
+        ev.data.ptr = &conn;
+        epoll_ctl(epfd, EPOLL_CTL_MOD, conn.fd, &ev);
+        return true;
+    }
+
+    static int keyAt(const uint8_t* payload, size_t index) {
+        return (int)(uint32_t)getFixed(payload + 4 * index, 4);
+    }
+
+    // One sorted traversal for the whole request instead of one per key
+    void applyKeys(MarkedList::BatchOp::Type type, const uint8_t* keys, uint32_t count) {
+        ops.resize(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            ops[i] = MarkedList::BatchOp{type, keyAt(keys, i)};
+        }
+        list.applyBatch(ops, results, pool, threadID);
+    }
+
+    void execute(uint8_t op, uint32_t id, const uint8_t* payload, uint32_t len,
+                 std::vector<uint8_t>& out) {
+        size_t start = out.size();
+        out.resize(start + PROTOCOL_HEADER_SIZE);
+        uint8_t status = STATUS_OK;
+
+        uint32_t count = (len >= 4) ? (uint32_t)getFixed(payload, 4) : 0;
+        bool batch = (len >= 4 && len == 4 + 4ull * count);
+        const uint8_t* keys = payload + 4;
+        uint8_t word[4];
+
+        switch (op) {
+        case OP_INSERT:
+            if (!batch) {
+                status = STATUS_BAD_REQUEST;
+                break;
+            }
+            applyKeys(MarkedList::BatchOp::Type::Insert, keys, count);
+            putFixed(word, count, 4);
+            out.insert(out.end(), word, word + 4);
+            break;
+
+        case OP_REMOVE:
+        case OP_CONTAINS:
+            if (!batch) {
+                status = STATUS_BAD_REQUEST;
+                break;
+            }
+            applyKeys(op == OP_REMOVE ? MarkedList::BatchOp::Type::Remove : MarkedList::BatchOp::Type::Contains,
+                      keys, count);
+            putFixed(word, count, 4);
+            out.insert(out.end(), word, word + 4);
+            out.insert(out.end(), results.begin(), results.end());
+            break;
+
+        case OP_RANGE: {
+            if (len != 12) {
+                status = STATUS_BAD_REQUEST;
+                break;
+            }
+            int lo = keyAt(payload, 0);
+            int hi = keyAt(payload, 1);
+            uint32_t limit = std::min<uint32_t>((uint32_t)getFixed(payload + 8, 4), PROTOCOL_MAX_RANGE);
+            std::vector<int> found;
+            list.rangeScan(lo, hi, found, threadID, (int)limit);
+            putFixed(word, found.size(), 4);
+            out.insert(out.end(), word, word + 4);
+            for (int key : found) {
+                putFixed(word, (uint32_t)key, 4);
+                out.insert(out.end(), word, word + 4);
+            }
+            break;
+        }
+
+        case OP_LENGTH:
+            if (len != 0) {
+                status = STATUS_BAD_REQUEST;
+                break;
+            }
+            putFixed(word, (uint32_t)list.get_length(), 4);
+            out.insert(out.end(), word, word + 4);
+            break;
+
+        default:
+            status = STATUS_BAD_REQUEST;
+            break;
+        }
+
+        if (status != STATUS_OK) {
+            out.resize(start + PROTOCOL_HEADER_SIZE);
+        }
+        uint8_t* header = out.data() + start;
+        putFixed(header, out.size() - start - PROTOCOL_HEADER_SIZE, 4);
+        putFixed(header + 4, id, 4);
+        header[8] = status;
+        header[9] = header[10] = header[11] = 0;
+    }
+};
+
+int main(int argc, char** argv) {
+    std::string path = argc > 1 ? argv[1] : PROTOCOL_DEFAULT_SOCKET;
+    int numWorkers = argc > 2 ? std::atoi(argv[2]) : 4;
+    if (numWorkers < 1) {
+        numWorkers = 1;
+    }
+    if (numWorkers > MAX_THREADS) {
+        numWorkers = MAX_THREADS;
+    }
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "Socket path too long: " << path << std::endl;
+        return 1;
+    }
+    std::strcpy(addr.sun_path, path.c_str());
+
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    int listener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    unlink(path.c_str());
+    if (listener < 0 || bind(listener, (sockaddr*)&addr, sizeof(addr)) != 0 ||
+        listen(listener, SOMAXCONN) != 0) {
+        std::cerr << "Cannot listen on " << path << ": " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+
+    MarkedList list;
+    std::vector<Worker*> workers;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < numWorkers; ++i) {
+        workers.push_back(new Worker(list, i));
+        threads.emplace_back(&Worker::run, workers.back());
+    }
+    std::cout << "Serving on " << path << " with " << numWorkers << " workers" << std::endl;
+
+    int next = 0;
+    while (!stopping.load()) {
+        pollfd pfd{listener, POLLIN, 0};
+        if (poll(&pfd, 1, SERVER_POLL_MS) <= 0) {
+            continue;
+        }
+        int fd;
+        while ((fd = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+            workers[next]->add(fd);
+            next = (next + 1) % numWorkers;
+        }
+    }
+
+    for (std::thread& t : threads) {
+        t.join();
+    }
+    for (Worker* worker : workers) {
+        delete worker;
+    }
+    ::close(listener);
+    unlink(path.c_str());
+    return 0;
+}
@@ -0,0 +1,419 @@
+#include "lsm-set.hpp"
+
+#include <algorithm>
+#include <queue>
+
+LsmSet::Memtable::Memtable() : writers(0), sealed(false) {}
+
+int LsmSet::Memtable::entries() {
+    return live.get_length() + tombstones.get_length();
+}
+
+LsmSet::Run::Run(std::vector<int> keys, std::vector<uint8_t> removed)
+    : keys(std::move(keys)), removed(std::move(removed)) {
+    size_t bits = std::max<size_t>(64, this->keys.size() * BLOOM_BITS_PER_KEY);
+    bloom.assign((bits + 63) / 64, 0);
+    bits = bloom.size() * 64;
+    for (int key : this->keys) {
+        uint64_t h = hashKey(key);
+        uint64_t step = (h >> 32) | 1;
+        for (int i = 0; i < BLOOM_HASHES; ++i) {
+            uint64_t bit = (h + i * step) % bits;
+            bloom[bit / 64] |= 1ull << (bit % 64);
+        }
+    }
+}
+
+bool LsmSet::Run::mayContain(int val) const {
+    uint64_t bits = bloom.size() * 64;
+    uint64_t h = hashKey(val);
+    uint64_t step = (h >> 32) | 1;
+    for (int i = 0; i < BLOOM_HASHES; ++i) {
+        uint64_t bit = (h + i * step) % bits;
+        if (!(bloom[bit / 64] & (1ull << (bit % 64)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+LsmSet::LsmSet()
+    : flushRequested(false), stopping(false), flushesStarted(0), flushesCompleted(0), flushPending(false) {
+    Version* initial = new Version();
+    initial->active = std::make_shared<Memtable>();
+    current.store(initial, std::memory_order_release);
+    background = std::thread(&LsmSet::backgroundLoop, this);
+}
+
+LsmSet::~LsmSet() {
+    {
+        std::lock_guard<std::mutex> lock(backgroundMutex);
+        stopping = true;
+    }
+    backgroundCv.notify_all();
+    background.join();
+    delete current.load(std::memory_order_relaxed);
+}
+
+// splitmix64 finalizer
+uint64_t LsmSet::hashKey(int val) {
+    uint64_t x = (uint64_t)(uint32_t)val + 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+LsmSet::Lookup LsmSet::lookup(Memtable* memtable, int val, int threadID) {
+    // Inserts add the key before clearing its tombstone and removes add the
+    // tombstone before unlinking the key, so checking 'live' first never
+    // reports a state that did not exist.
+    if (memtable->live.contains(val, threadID)) {
+        return Lookup::Present;
+    }
+    if (memtable->tombstones.contains(val, threadID)) {
+        return Lookup::Removed;
+    }
+    return Lookup::Unknown;
+}
+
+LsmSet::Lookup LsmSet::lookup(const Run& run, int val) {
+    if (!run.mayContain(val)) {
+        return Lookup::Unknown;
+    }
+    auto pos = std::lower_bound(run.keys.begin(), run.keys.end(), val);
+    if (pos == run.keys.end() || *pos != val) {
+        return Lookup::Unknown;
+    }
+    return run.removed[pos - run.keys.begin()] ? Lookup::Removed : Lookup::Present;
+}
+
+LsmSet::Version* LsmSet::protect(int threadID) {
+    Version* version = current.load(std::memory_order_acquire);
+    while (true) {
+        AccessedPointers::store(threadID, version, ENCLOSING_PTR_INDEX);
+        Version* again = current.load(std::memory_order_acquire);
+        if (again == version) {
+            return version;
+        }
+        version = again;
+    }
+}
+
+// Register as a writer of the active memtable. The flusher seals the
+// memtable before waiting for 'writers' to drain, so a writer that sees
+// it unsealed after registering is always waited for.
+LsmSet::Memtable* LsmSet::beginWrite(int threadID) {
+    while (true) {
+        Memtable* memtable = protect(threadID)->active.get();
+        memtable->writers.fetch_add(1);
+        if (!memtable->sealed.load()) {
+            return memtable;
+        }
+        memtable->writers.fetch_sub(1);
+        std::this_thread::yield();
+    }
+}
+
+void LsmSet::endWrite(Memtable* memtable, int threadID) {
+    bool full = memtable->entries() >= MEMTABLE_LIMIT;
+    memtable->writers.fetch_sub(1);
+    AccessedPointers::clear(threadID, ENCLOSING_PTR_INDEX);
+    if (full) {
+        requestFlush();
+    }
+}
+
+void LsmSet::requestFlush() {
+    if (flushPending.exchange(true)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(backgroundMutex);
+        flushRequested = true;
+    }
+    backgroundCv.notify_one();
+}
+
+void LsmSet::insert(int val, int threadID) {
+    std::lock_guard<std::mutex> stripe(stripes[hashKey(val) % LSM_STRIPES]);
+    Memtable* memtable = beginWrite(threadID);
+    if (!memtable->live.contains(val, threadID)) {
+        memtable->live.insert(val, threadID);
+    }
+    memtable->tombstones.remove(val, threadID);
+    endWrite(memtable, threadID);
+}
+
+void LsmSet::remove(int val, int threadID) {
+    std::lock_guard<std::mutex> stripe(stripes[hashKey(val) % LSM_STRIPES]);
+    Memtable* memtable = beginWrite(threadID);
+    if (!memtable->tombstones.contains(val, threadID)) {
+        memtable->tombstones.insert(val, threadID);
+    }
+    memtable->live.remove(val, threadID);
+    endWrite(memtable, threadID);
+}
+
+bool LsmSet::contains(int val, int threadID) {
+    Version* version = protect(threadID);
+
+    Lookup result = lookup(version->active.get(), val, threadID);
+    if (result == Lookup::Unknown && version->sealed) {
+        result = lookup(version->sealed.get(), val, threadID);
+    }
+    for (size_t i = 0; result == Lookup::Unknown && i < version->runs.size(); ++i) {
+        result = lookup(*version->runs[i], val);
+    }
+
+    AccessedPointers::clear(threadID, ENCLOSING_PTR_INDEX);
+    return result == Lookup::Present;
+}
+
+// An iteration already running may have swapped the memtable before the
+// caller's last writes, so only the next one to start is waited for
+void LsmSet::flush() {
+    std::unique_lock<std::mutex> lock(backgroundMutex);
+    long target = flushesStarted + 1;
+    flushRequested = true;
+    backgroundCv.notify_one();
+    flushedCv.wait(lock, [&] { return flushesCompleted >= target; });
+}
+
+// Publish a new version. Only the background thread replaces versions.
+void LsmSet::install(Version* next) {
+    Version* old = current.exchange(next, std::memory_order_acq_rel);
+    retireList.retire(old);
+}
+
+void LsmSet::backgroundLoop() {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(backgroundMutex);
+            backgroundCv.wait(lock, [&] { return flushRequested || stopping; });
+            if (!flushRequested) {
+                return;
+            }
+            flushRequested = false;
+            flushesStarted++;
+        }
+        flushPending.store(false);
+
+        flushMemtable();
+        if (current.load()->runs.size() > LSM_MAX_RUNS) {
+            mergeRuns();
+        }
+        {
+            std::lock_guard<std::mutex> lock(reclaimMutex);
+            retireList.scanAndReclaim();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(backgroundMutex);
+            flushesCompleted++;
+        }
+        flushedCv.notify_all();
+    }
+}
+
+void LsmSet::flushMemtable() {
+    Version* version = current.load();
+    if (version->active->entries() == 0) {
+        return;
+    }
+
+    // (1) Swap in an empty memtable; the full one stays readable while sealed
+    Version* swapped = new Version();
+    swapped->active = std::make_shared<Memtable>();
+    swapped->sealed = version->active;
+    swapped->runs = version->runs;
+    install(swapped);
+
+    Memtable* sealed = swapped->sealed.get();
+    sealed->sealed.store(true);
+    while (sealed->writers.load() != 0) {
+        std::this_thread::yield();
+    }
+
+    // (2) Merge its keys and tombstones into one sorted run
+    std::vector<int> live = sealed->live.keys();
+    std::vector<int> dead = sealed->tombstones.keys();
+    std::vector<int> keys;
+    std::vector<uint8_t> removed;
+    keys.reserve(live.size() + dead.size());
+    removed.reserve(live.size() + dead.size());
+    size_t i = 0, j = 0;
+    while (i < live.size() || j < dead.size()) {
+        if (j == dead.size() || (i < live.size() && live[i] < dead[j])) {
+            keys.push_back(live[i++]);
+            removed.push_back(0);
+        } else {
+            keys.push_back(dead[j++]);
+            removed.push_back(1);
+        }
+    }
+
+    // (3) Publish the run in place of the sealed memtable
+    Version* flushed = new Version();
+    flushed->active = swapped->active;
+    flushed->runs.push_back(std::make_shared<Run>(std::move(keys), std::move(removed)));
+    flushed->runs.insert(flushed->runs.end(), swapped->runs.begin(), swapped->runs.end());
+    install(flushed);
+}
+
+// Merge every run into one. The result is the oldest run, so tombstones
+// have nothing left to shadow and are dropped.
+void LsmSet::mergeRuns() {
+    Version* version = current.load();
+    const std::vector<std::shared_ptr<Run>>& runs = version->runs;
+
+    // Heap entries are (key, run index); for equal keys the newest run wins
+    typedef std::pair<int, size_t> Entry;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> heap;
+    std::vector<size_t> positions(runs.size(), 0);
+    for (size_t r = 0; r < runs.size(); ++r) {
+        if (!runs[r]->keys.empty()) {
+            heap.push(Entry(runs[r]->keys[0], r));
+        }
+    }
+
+    std::vector<int> keys;
+    std::vector<uint8_t> removed;
+    while (!heap.empty()) {
+        Entry top = heap.top();
+        int key = top.first;
+        bool isRemoved = runs[top.second]->removed[positions[top.second]];
+
+        // Skip the same key in older runs
+        while (!heap.empty() && heap.top().first == key) {
+            size_t r = heap.top().second;
+            heap.pop();
+            if (++positions[r] < runs[r]->keys.size()) {
+                heap.push(Entry(runs[r]->keys[positions[r]], r));
+            }
+        }
+
+        if (!isRemoved) {
+            keys.push_back(key);
+            removed.push_back(0);
+        }
+    }
+
+    Version* merged = new Version();
+    merged->active = version->active;
+    merged->sealed = version->sealed;
+    merged->runs.push_back(std::make_shared<Run>(std::move(keys), std::move(removed)));
+    install(merged);
+}
+
+// Merge the layers, newest first, in one pass over each: the newest entry
+// for a key decides it, as in mergeRuns. For printing, counting and
+// checking only.
+void LsmSet::forEachLive(const std::function<void(int)>& visit) {
+    std::lock_guard<std::mutex> lock(reclaimMutex);
+    Version* version = current.load(std::memory_order_acquire);
+
+    // A memtable layer checks 'live' before 'tombstones', like lookup()
+    std::vector<std::vector<int>> memKeys;
+    std::vector<std::vector<uint8_t>> memRemoved;
+    Memtable* memtables[] = {version->active.get(), version->sealed.get()};
+    for (Memtable* memtable : memtables) {
+        if (!memtable) {
+            continue;
+        }
+        std::vector<int> live = memtable->live.keys();
+        std::vector<int> dead = memtable->tombstones.keys();
+        memKeys.emplace_back();
+        memRemoved.emplace_back();
+        size_t i = 0, j = 0;
+        while (i < live.size() || j < dead.size()) {
+            if (j == dead.size() || (i < live.size() && live[i] <= dead[j])) {
+                j += (j < dead.size() && live[i] == dead[j]);
+                memKeys.back().push_back(live[i++]);
+                memRemoved.back().push_back(0);
+            } else {
+                memKeys.back().push_back(dead[j++]);
+                memRemoved.back().push_back(1);
+            }
+        }
+    }
+
+    struct Layer {
+        const std::vector<int>* keys;
+        const std::vector<uint8_t>* removed;
+    };
+    std::vector<Layer> layers;
+    for (size_t m = 0; m < memKeys.size(); ++m) {
+        layers.push_back(Layer{&memKeys[m], &memRemoved[m]});
+    }
+    for (auto& run : version->runs) {
+        layers.push_back(Layer{&run->keys, &run->removed});
+    }
+
+    // Heap entries are (key, layer index); for equal keys the newest layer wins
+    typedef std::pair<int, size_t> Entry;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> heap;
+    std::vector<size_t> positions(layers.size(), 0);
+    for (size_t l = 0; l < layers.size(); ++l) {
+        if (!layers[l].keys->empty()) {
+            heap.push(Entry((*layers[l].keys)[0], l));
+        }
+    }
+    while (!heap.empty()) {
+        Entry top = heap.top();
+        int key = top.first;
+        bool isRemoved = (*layers[top.second].removed)[positions[top.second]];
+        while (!heap.empty() && heap.top().first == key) {
+            size_t l = heap.top().second;
+            heap.pop();
+            if (++positions[l] < layers[l].keys->size()) {
+                heap.push(Entry((*layers[l].keys)[positions[l]], l));
+            }
+        }
+        if (!isRemoved) {
+            visit(key);
+        }
+    }
+}
+
+std::vector<int> LsmSet::liveKeys() {
+    std::vector<int> out;
+    forEachLive([&](int key) { out.push_back(key); });
+    return out;
+}
+
+void LsmSet::printList() {
+    for (int key : liveKeys()) {
+        std::cout << key << " ";
+    }
+    std::cout << std::endl;
+}
+
+int LsmSet::get_length() {
+    int count = 0;
+    forEachLive([&](int) { count++; });
+    return count;
+}
+
+int LsmSet::get_runs() {
+    std::lock_guard<std::mutex> lock(reclaimMutex);
+    return (int)current.load(std::memory_order_acquire)->runs.size();
+}
+
+int LsmSet::get_buffered() {
+    std::lock_guard<std::mutex> lock(reclaimMutex);
+    Version* version = current.load(std::memory_order_acquire);
+    return version->active->entries() + (version->sealed ? version->sealed->entries() : 0);
+}
+
+bool LsmSet::checkList() {
+    std::lock_guard<std::mutex> lock(reclaimMutex);
+    Version* version = current.load(std::memory_order_acquire);
+    for (auto& run : version->runs) {
+        for (size_t i = 1; i < run->keys.size(); ++i) {
+            if (run->keys[i] <= run->keys[i - 1]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,108 @@
+#ifndef LSM_SET_H
+#define LSM_SET_H
+
+#include <iostream>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include <memory>
+#include <vector>
+#include <functional>
+#include <cstdint>
+
+#include "concurrent-linked-list.hpp"
+#include "reclamation.hpp"
+
+#define MEMTABLE_LIMIT 512  // Entries (keys plus tombstones) before the memtable is flushed
+#define LSM_MAX_RUNS 4      // More runs than this are merged into one
+#define LSM_STRIPES 64      // Locks serializing updates to the same key
+#define BLOOM_BITS_PER_KEY 10
+#define BLOOM_HASHES 7
+
+// ------------------------------------------------------
+// Log-Structured Merge Set
+// ------------------------------------------------------
+// Updates are blind writes into a small mutable memtable made of two
+// MarkedLists (live keys and tombstones). A background thread seals a full
+// memtable, flushes it into an immutable sorted run with a Bloom filter and
+// merges runs once there are too many. Lookups check the memtables, then
+// the runs from newest to oldest. The memtables and runs in use form an
+// immutable Version that readers protect with ENCLOSING_PTR_INDEX.
+class LsmSet {
+private:
+    struct Memtable {
+        MarkedList live;
+        MarkedList tombstones;
+        std::atomic<int> writers; // Updates in progress
+        std::atomic<bool> sealed; // No new updates once set
+
+        Memtable();
+        int entries();
+    };
+
+    struct Run {
+        std::vector<int> keys;        // Sorted and unique
+        std::vector<uint8_t> removed; // Tombstone flag per key
+        std::vector<uint64_t> bloom;
+
+        Run(std::vector<int> keys, std::vector<uint8_t> removed);
+        bool mayContain(int val) const;
+    };
+
+    struct Version {
+        std::shared_ptr<Memtable> active;
+        std::shared_ptr<Memtable> sealed;      // Being flushed, or null
+        std::vector<std::shared_ptr<Run>> runs; // Newest first
+    };
+
+    enum class Lookup { Present, Removed, Unknown };
+
+    std::atomic<Version*> current;
+    RetireList<Version> retireList; // Replaced versions waiting to be freed
+    std::mutex reclaimMutex; // Keeps versions alive for the unprotected debug walks
+    std::mutex stripes[LSM_STRIPES];
+
+    std::thread background;
+    std::mutex backgroundMutex;
+    std::condition_variable backgroundCv;
+    std::condition_variable flushedCv;
+    bool flushRequested;
+    bool stopping;
+    long flushesStarted;   // Background iterations that took a request
+    long flushesCompleted;
+    std::atomic<bool> flushPending;
+
+    static uint64_t hashKey(int val);
+    static Lookup lookup(Memtable* memtable, int val, int threadID);
+    static Lookup lookup(const Run& run, int val);
+
+    Version* protect(int threadID);
+    Memtable* beginWrite(int threadID);
+    void endWrite(Memtable* memtable, int threadID);
+    void requestFlush();
+    void install(Version* next);
+    void backgroundLoop();
+    void flushMemtable();
+    void mergeRuns();
+    void forEachLive(const std::function<void(int)>& visit); // Live keys in ascending order
+    std::vector<int> liveKeys();
+
+public:
+    LsmSet();
+    ~LsmSet();
+
+    void insert(int val, int threadID); // Blind insert of 'val'
+    void remove(int val, int threadID); // Blind remove: writes a tombstone for 'val'
+    bool contains(int val, int threadID); // Check if 'val' is in the set
+
+    void flush(); // Flush the memtable and wait for the background thread
+
+    void printList(); // Print the set contents in ascending order
+    int get_length();
+    int get_runs();
+    int get_buffered(); // Memtable entries not yet in a run
+    bool checkList();
+};
+
+#endif
@@ -14,7 +14,7 @@ int main() {
     const int numInsertThreads = 4;
     const int numRemoveThreads = 4;
     const int opsPerThread = 1000;
-    const int print_update = opsPerThread/10;
+    [[maybe_unused]] const int print_update = opsPerThread/10;
 
     // A random seed
     auto seed = std::random_device{}();
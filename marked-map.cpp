@@ -0,0 +1,180 @@
+#include "marked-map.hpp"
+
+MarkedMap::Node::Node(int key, long long value, Node* nxt)
+    : key(key), value(value), next(nxt), removed(false) {}
+
+MarkedMap::MarkedMap() : list(new Node(-1, 0)) {} // Sentinel with dummy key; never removed
+
+// A node removed after the traversal may have been replaced by a new node
+// for the same key, so that case searches again
+MarkedMap::Node* MarkedMap::lockKey(int key, int threadID, std::unique_lock<std::mutex>& lock) {
+    while (true) {
+        Node* pred;
+        Node* curr;
+        list.findWindow(key, threadID, pred, curr);
+        if (!curr || curr->key != key) {
+            AccessedPointers::reset(threadID);
+            return nullptr;
+        }
+        lock = std::unique_lock<std::mutex>(curr->m);
+        if (!curr->removed) {
+            AccessedPointers::reset(threadID);
+            return curr;
+        }
+        lock.unlock();
+    }
+}
+
+void MarkedMap::scanAndReclaim() {
+    list.scanAndReclaim();
+}
+
+bool MarkedMap::insert(int key, long long value, int threadID) {
+    Node* pred;
+    Node* curr;
+    {
+        std::unique_lock<std::mutex> lockPred, lockCurr;
+        list.lockWindow(key, threadID, pred, curr, lockPred, lockCurr);
+        if (curr && curr->key == key) {
+            return false;
+        }
+        pred->next = new Node(key, value, curr);
+    }
+    list.recordUpdate(1);
+    return true;
+}
+
+bool MarkedMap::remove(int key, int threadID) {
+    Node* pred;
+    Node* curr;
+    {
+        std::unique_lock<std::mutex> lockPred, lockCurr;
+        list.lockWindow(key, threadID, pred, curr, lockPred, lockCurr);
+        if (!curr || curr->key != key) {
+            return false;
+        }
+        curr->removed = true;
+        pred->next = curr->next;
+        list.retireList.retire(curr);
+    }
+    list.recordUpdate(-1);
+    return true;
+}
+
+bool MarkedMap::contains(int key, int threadID) {
+    long long value;
+    return get(key, value, threadID);
+}
+
+bool MarkedMap::get(int key, long long& value, int threadID) {
+    Node* pred;
+    Node* curr;
+    list.findWindow(key, threadID, pred, curr);
+
+    bool found = (curr && !curr->removed && curr->key == key);
+    if (found) {
+        value = curr->value.load(std::memory_order_acquire);
+    }
+    AccessedPointers::reset(threadID);
+    return found;
+}
+
+bool MarkedMap::replace(int key, long long newValue, int threadID, long long* old) {
+    std::unique_lock<std::mutex> lock;
+    Node* node = lockKey(key, threadID, lock);
+    if (!node) {
+        return false;
+    }
+    long long prev = node->value.exchange(newValue, std::memory_order_acq_rel);
+    if (old) {
+        *old = prev;
+    }
+    return true;
+}
+
+bool MarkedMap::compareAndSet(int key, long long expected, long long desired, int threadID, long long* actual) {
+    std::unique_lock<std::mutex> lock;
+    Node* node = lockKey(key, threadID, lock);
+    if (!node) {
+        return false;
+    }
+    long long seen = node->value.load(std::memory_order_relaxed); // Writers hold the lock
+    if (actual) {
+        *actual = seen;
+    }
+    if (seen != expected) {
+        return false;
+    }
+    node->value.store(desired, std::memory_order_release);
+    return true;
+}
+
+long long MarkedMap::upsert(int key, long long value, const std::function<long long(long long, long long)>& merge,
+                            int threadID) {
+    Node* pred;
+    Node* curr;
+    {
+        std::unique_lock<std::mutex> lockPred, lockCurr;
+        list.lockWindow(key, threadID, pred, curr, lockPred, lockCurr);
+        if (curr && curr->key == key) {
+            long long merged = merge(curr->value.load(std::memory_order_relaxed), value);
+            curr->value.store(merged, std::memory_order_release);
+            return merged;
+        }
+        pred->next = new Node(key, value, curr);
+    }
+    list.recordUpdate(1);
+    return value;
+}
+
+// A present key is returned from the traversal without locks. Otherwise
+// 'curr' is not the key's node, or it was removed and validate fails.
+long long MarkedMap::computeIfAbsent(int key, const std::function<long long(int)>& compute, int threadID) {
+    while (true) {
+        Node* pred;
+        Node* curr;
+        list.findWindow(key, threadID, pred, curr);
+        long long value;
+        if (curr && curr->key == key && !curr->removed) {
+            value = curr->value.load(std::memory_order_acquire);
+            AccessedPointers::reset(threadID);
+            return value;
+        }
+
+        {
+            std::unique_lock<std::mutex> lockPred(pred->m);
+            std::unique_lock<std::mutex> lockCurr;
+            if (curr) {
+                lockCurr = std::unique_lock<std::mutex>(curr->m);
+            }
+            if (!list.validate(pred, curr)) {
+                AccessedPointers::reset(threadID);
+                continue;
+            }
+            value = compute(key);
+            pred->next = new Node(key, value, curr);
+        }
+        AccessedPointers::reset(threadID);
+        list.recordUpdate(1);
+        return value;
+    }
+}
+
+void MarkedMap::printList() {
+    Node* curr = list.head->next;
+    while (curr) {
+        if (!curr->removed) {
+            std::cout << curr->key << "=" << curr->value.load() << " ";
+        }
+        curr = curr->next;
+    }
+    std::cout << std::endl;
+}
+
+int MarkedMap::get_length() {
+    return list.length;
+}
+
+bool MarkedMap::checkList() {
+    return list.checkList();
+}
@@ -0,0 +1,67 @@
+#ifndef MARKED_MAP_H
+#define MARKED_MAP_H
+
+#include <iostream>
+#include <mutex>
+#include <atomic>
+#include <functional>
+
+#include "lazy-list.hpp"
+
+// ------------------------------------------------------
+// Lazy List Map (int keys, long long values)
+// ------------------------------------------------------
+// The lazy list (LazyList) with one value per key. Reads are lock-free: a
+// value is an atomic word, so get() never sees a torn update. Every
+// conditional update makes one traversal and then decides under the node
+// locks. An update that only changes a value locks just the key's node,
+// since a locked live node cannot be unlinked. An update that may link a
+// node locks the window like insert.
+class MarkedMap {
+private:
+    struct Node {
+        int key;
+        std::atomic<long long> value;
+        Node* next;
+        mutable std::mutex m; // Protects this node
+        bool removed;         // 'true' if this node is logically removed
+
+        Node(int key, long long value, Node* nxt = nullptr);
+    };
+
+    struct Order { // Key order for LazyList
+        int operator()(const Node* node, int key) const { return (node->key > key) - (node->key < key); }
+        int operator()(const Node* a, const Node* b) const { return (a->key > b->key) - (a->key < b->key); }
+    };
+
+    LazyList<Node, int, Order> list;
+
+    Node* lockKey(int key, int threadID, std::unique_lock<std::mutex>& lock); // Live node of 'key', locked; null if absent
+
+public:
+    MarkedMap();
+
+    bool insert(int key, long long value, int threadID); // false if 'key' is already present
+    bool remove(int key, int threadID); // Remove 'key' if it exists
+    bool contains(int key, int threadID);
+    bool get(int key, long long& value, int threadID); // false if 'key' is absent
+
+    // Set the value of a present key; '*old' receives the value it replaced
+    bool replace(int key, long long newValue, int threadID, long long* old = nullptr);
+    // Set the value to 'desired' only if it is 'expected'; '*actual' receives the value seen
+    bool compareAndSet(int key, long long expected, long long desired, int threadID, long long* actual = nullptr);
+    // Insert 'value', or set merge(old, value) if 'key' is present; returns the resulting value
+    long long upsert(int key, long long value, const std::function<long long(long long, long long)>& merge,
+                     int threadID);
+    // Return the value of 'key', first inserting compute(key) if it is absent.
+    // 'compute' runs under the window locks, at most once per call.
+    long long computeIfAbsent(int key, const std::function<long long(int)>& compute, int threadID);
+
+    void scanAndReclaim(); // Scan and Reclaim Memory
+
+    void printList(); // Print the key=value pairs in ascending key order
+    int get_length();
+    bool checkList();
+};
+
+#endif
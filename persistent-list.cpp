@@ -0,0 +1,371 @@
+#include "persistent-list.hpp"
+
+#include <cstring>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+PersistentList::NodeLock::NodeLock(Node* node) : node(nullptr) {
+    acquire(node);
+}
+
+PersistentList::NodeLock::~NodeLock() {
+    if (node) {
+        node->lock.store(0, std::memory_order_release);
+    }
+}
+
+void PersistentList::NodeLock::acquire(Node* target) {
+    while (target->lock.exchange(1, std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+    node = target;
+}
+
+PersistentList::PersistentList()
+    : fd(-1), base(nullptr), header(nullptr), head(nullptr), wasRecovered(false),
+      retireList([this](Node* node) { release(node); }), operationCounter(0) {}
+
+PersistentList::~PersistentList() {
+    close();
+}
+
+PersistentList::Node* PersistentList::at(uint64_t offset) const {
+    return offset ? reinterpret_cast<Node*>(base + offset) : nullptr;
+}
+
+// Slots start on the first cache line after the header
+uint64_t PersistentList::nodeArea() {
+    return 64 * ((sizeof(Header) + 63) / 64);
+}
+
+uint64_t PersistentList::offsetOf(const Node* node) const {
+    return node ? reinterpret_cast<const char*>(node) - base : 0;
+}
+
+bool PersistentList::open(const std::string& path, size_t capacity) {
+    if (base) {
+        return false;
+    }
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    // Held until close(), and dropped by the kernel if this process dies
+    if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+        close();
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close();
+        return false;
+    }
+    bool created = (st.st_size == 0);
+    if (created) {
+        if (capacity < nodeArea() + 2 * sizeof(Node) || ftruncate(fd, capacity) != 0) {
+            close();
+            return false;
+        }
+    } else {
+        capacity = st.st_size;
+    }
+
+    void* mapping = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+        close();
+        return false;
+    }
+    base = static_cast<char*>(mapping);
+    header = reinterpret_cast<Header*>(base);
+
+    if (created) {
+        std::memcpy(header->magic, PERSISTENT_MAGIC, 8);
+        header->version = PERSISTENT_VERSION;
+        header->capacity = capacity;
+        header->head = nodeArea();
+        header->top.store(nodeArea() + sizeof(Node), std::memory_order_relaxed);
+        header->freeList = 0;
+        header->length.store(0, std::memory_order_relaxed);
+        Node* sentinel = at(header->head);
+        sentinel->next.store(0, std::memory_order_relaxed);
+        sentinel->value = -1;
+        sentinel->removed.store(0, std::memory_order_relaxed);
+    } else if (std::memcmp(header->magic, PERSISTENT_MAGIC, 8) != 0 ||
+               header->version != PERSISTENT_VERSION || header->capacity != capacity) {
+        close();
+        return false;
+    }
+
+    head = at(header->head);
+    // With the lock held, a set 'inUse' can only be left by a process that died
+    wasRecovered = !created && header->inUse;
+    if (wasRecovered) {
+        recover();
+    }
+    header->inUse = 1;
+    return true;
+}
+
+void PersistentList::close() {
+    if (base) {
+        retireList.releaseAll();
+        header->inUse = 0;
+        msync(base, header->capacity, MS_SYNC);
+        munmap(base, header->capacity);
+        base = nullptr;
+        header = nullptr;
+        head = nullptr;
+    }
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+bool PersistentList::recovered() {
+    return wasRecovered;
+}
+
+bool PersistentList::sync() {
+    return base && msync(base, header->capacity, MS_SYNC) == 0;
+}
+
+// Single-threaded repair of a file whose last user crashed
+void PersistentList::recover() {
+    uint64_t first = header->head;
+    uint64_t top = header->top.load(std::memory_order_relaxed);
+    size_t slots = (top - first) / sizeof(Node);
+    auto valid = [&](uint64_t offset) {
+        return offset >= first && offset < top && (offset - first) % sizeof(Node) == 0;
+    };
+
+    // (1) Release locks held by the crashed process
+    for (uint64_t offset = first; offset < top; offset += sizeof(Node)) {
+        reinterpret_cast<Node*>(base + offset)->lock.store(0, std::memory_order_relaxed);
+    }
+
+    // (2) Unlink nodes marked removed but not yet unlinked; cut the chain at
+    // any offset that cannot be a slot or was already visited
+    std::vector<bool> reachable(slots, false);
+    reachable[0] = true;
+    Node* pred = head;
+    int64_t count = 0;
+    uint64_t offset = head->next.load(std::memory_order_relaxed);
+    while (offset) {
+        if (!valid(offset) || reachable[(offset - first) / sizeof(Node)]) {
+            pred->next.store(0, std::memory_order_relaxed);
+            break;
+        }
+        Node* curr = at(offset);
+        uint64_t next = curr->next.load(std::memory_order_relaxed);
+        if (curr->removed.load(std::memory_order_relaxed)) {
+            pred->next.store(next, std::memory_order_relaxed);
+        } else {
+            reachable[(offset - first) / sizeof(Node)] = true;
+            pred = curr;
+            count++;
+        }
+        offset = next;
+    }
+
+    // (3) Every unlinked slot was free or retired but not yet reclaimed
+    header->freeList = 0;
+    for (size_t i = slots; i-- > 1;) {
+        if (!reachable[i]) {
+            Node* node = at(first + i * sizeof(Node));
+            node->removed.store(0, std::memory_order_relaxed);
+            node->next.store(header->freeList, std::memory_order_relaxed);
+            header->freeList = first + i * sizeof(Node);
+        }
+    }
+    header->length.store(count, std::memory_order_relaxed);
+}
+
+PersistentList::Node* PersistentList::allocate(int val, uint64_t next) {
+    Node* node = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(allocMutex);
+        if (header->freeList) {
+            node = at(header->freeList);
+            header->freeList = node->next.load(std::memory_order_relaxed);
+        } else {
+            uint64_t top = header->top.load(std::memory_order_relaxed);
+            if (top + sizeof(Node) > header->capacity) {
+                return nullptr;
+            }
+            node = at(top);
+            header->top.store(top + sizeof(Node), std::memory_order_relaxed);
+        }
+    }
+    node->value = val;
+    node->lock.store(0, std::memory_order_relaxed);
+    node->removed.store(0, std::memory_order_relaxed);
+    node->next.store(next, std::memory_order_relaxed);
+    return node;
+}
+
+void PersistentList::release(Node* node) {
+    std::lock_guard<std::mutex> lock(allocMutex);
+    node->next.store(header->freeList, std::memory_order_relaxed);
+    header->freeList = offsetOf(node);
+}
+
+bool PersistentList::validate(Node* pred, Node* curr) {
+    return (!pred->removed.load() && !(curr && curr->removed.load()) &&
+            at(pred->next.load()) == curr);
+}
+
+void PersistentList::findWindow(int val, int threadID, Node*& pred, Node*& curr) {
+    while (true) {
+        // Publish each node before following it, then re-check that it is
+        // still linked behind a live predecessor; otherwise restart.
+        int slot = 0;
+        pred = head;
+        curr = at(pred->next.load(std::memory_order_acquire));
+        AccessedPointers::store(threadID, curr, slot);
+        if (at(pred->next.load(std::memory_order_acquire)) != curr) {
+            continue;
+        }
+
+        bool restart = false;
+        while (curr && curr->value < val) {
+            Node* next = at(curr->next.load(std::memory_order_acquire));
+            slot = 1 - slot;
+            AccessedPointers::store(threadID, next, slot);
+            if (curr->removed.load() || at(curr->next.load(std::memory_order_acquire)) != next) {
+                restart = true;
+                break;
+            }
+            pred = curr;
+            curr = next;
+        }
+
+        if (!restart) {
+            return;
+        }
+    }
+}
+
+void PersistentList::countOperation() {
+    int length = get_length();
+    if (operationCounter.fetch_add(1, std::memory_order_relaxed) + 1 >= length) {
+        scanAndReclaim();
+        operationCounter.fetch_sub(length, std::memory_order_relaxed);
+    }
+}
+
+void PersistentList::scanAndReclaim() {
+    retireList.scanAndReclaim();
+}
+
+bool PersistentList::insert(int val, int threadID) {
+    while (true) {
+        Node* pred;
+        Node* curr;
+        findWindow(val, threadID, pred, curr);
+
+        {
+            NodeLock lockPred(pred);
+            NodeLock lockCurr;
+            if (curr) {
+                lockCurr.acquire(curr);
+            }
+
+            if (!validate(pred, curr)) {
+                AccessedPointers::reset(threadID);
+                continue;
+            }
+
+            Node* newNode = allocate(val, offsetOf(curr));
+            if (!newNode) {
+                AccessedPointers::reset(threadID);
+                return false;
+            }
+            pred->next.store(offsetOf(newNode), std::memory_order_release);
+        }
+
+        AccessedPointers::reset(threadID);
+        header->length.fetch_add(1, std::memory_order_relaxed);
+        countOperation();
+        return true;
+    }
+}
+
+bool PersistentList::remove(int val, int threadID) {
+    while (true) {
+        Node* pred;
+        Node* curr;
+        findWindow(val, threadID, pred, curr);
+
+        {
+            NodeLock lockPred(pred);
+            NodeLock lockCurr;
+            if (curr) {
+                lockCurr.acquire(curr);
+            }
+
+            if (!validate(pred, curr)) {
+                AccessedPointers::reset(threadID);
+                continue;
+            }
+
+            if (!curr || curr->value != val) {
+                AccessedPointers::reset(threadID);
+                return false;
+            }
+
+            // A crash between these two stores leaves a removed but linked
+            // node, which recover() unlinks
+            curr->removed.store(1);
+            pred->next.store(curr->next.load(), std::memory_order_release);
+            retireList.retire(curr);
+        }
+
+        AccessedPointers::reset(threadID);
+        header->length.fetch_sub(1, std::memory_order_relaxed);
+        countOperation();
+        return true;
+    }
+}
+
+bool PersistentList::contains(int val, int threadID) {
+    Node* pred;
+    Node* curr;
+    findWindow(val, threadID, pred, curr);
+
+    bool found = (curr && !curr->removed.load() && curr->value == val);
+    AccessedPointers::reset(threadID);
+    return found;
+}
+
+void PersistentList::printList() {
+    RetireList<Node>::ScanGuard guard(retireList);
+    for (Node* curr = at(head->next.load()); curr; curr = at(curr->next.load())) {
+        if (!curr->removed.load()) {
+            std::cout << curr->value << " ";
+        }
+    }
+    std::cout << std::endl;
+}
+
+int PersistentList::get_length() {
+    return header ? (int)header->length.load(std::memory_order_relaxed) : 0;
+}
+
+bool PersistentList::checkList() {
+    RetireList<Node>::ScanGuard guard(retireList);
+    Node* prev = nullptr;
+    for (Node* curr = at(head->next.load()); curr; curr = at(curr->next.load())) {
+        if (prev && curr->value < prev->value) {
+            return false;
+        }
+        prev = curr;
+    }
+    return true;
+}
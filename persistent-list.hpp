@@ -0,0 +1,102 @@
+#ifndef PERSISTENT_LIST_H
+#define PERSISTENT_LIST_H
+
+#include <iostream>
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+#include "reclamation.hpp"
+
+#define PERSISTENT_MAGIC "MLSTMMAP"
+#define PERSISTENT_VERSION 1
+#define PERSISTENT_DEFAULT_CAPACITY (1ull << 30) // File size; the file is sparse until nodes are used
+
+// ------------------------------------------------------
+// Memory-Mapped Persistent Lazy List
+// ------------------------------------------------------
+// The same optimistic list as MarkedList, but every node is a fixed-size
+// slot in a memory-mapped file and links are file offsets, so the list
+// survives a process restart and a new process can map it and serve
+// lookups at once. Node locks are spinlocks stored in the slot. One
+// process at a time may open the file: open() takes an exclusive flock
+// and fails while another process holds it. After a crash, open() resets
+// locks, unlinks nodes that were marked removed but not unlinked, and
+// rebuilds the free list from the unreachable slots.
+// Data reaches the file through the page cache, so a process crash loses
+// nothing; call sync() to also survive power loss.
+class PersistentList {
+private:
+    struct Node {
+        std::atomic<uint64_t> next; // Offset of the next node, 0 for none; links free slots too
+        int value;
+        std::atomic<uint32_t> lock;
+        std::atomic<uint32_t> removed;
+        uint32_t padding;
+    };
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t inUse;               // Set while a process has the file open
+        uint64_t capacity;            // File size in bytes
+        std::atomic<uint64_t> top;    // End of the slots handed out so far
+        uint64_t freeList;            // Offset of the first free slot
+        uint64_t head;                // Offset of the sentinel
+        std::atomic<int64_t> length;
+    };
+
+    class NodeLock {
+    public:
+        NodeLock() : node(nullptr) {}
+        explicit NodeLock(Node* node);
+        ~NodeLock();
+        void acquire(Node* node);
+
+    private:
+        Node* node;
+    };
+
+    int fd;
+    char* base;
+    Header* header;
+    Node* head;
+    bool wasRecovered;
+    std::mutex allocMutex; // Protects the free list and 'top'
+    RetireList<Node> retireList; // Unlinked slots waiting to return to the free list
+    std::atomic<int> operationCounter;
+
+    static uint64_t nodeArea();
+    Node* at(uint64_t offset) const;
+    uint64_t offsetOf(const Node* node) const;
+    Node* allocate(int val, uint64_t next);
+    void release(Node* node);
+    bool validate(Node* pred, Node* curr);
+    void findWindow(int val, int threadID, Node*& pred, Node*& curr);
+    void recover();
+    void countOperation();
+
+public:
+    PersistentList();
+    ~PersistentList(); // Unmaps the file and marks it cleanly closed
+
+    // Map 'path', creating it with 'capacity' bytes if it does not exist; false if another process has it open
+    bool open(const std::string& path, size_t capacity = PERSISTENT_DEFAULT_CAPACITY);
+    void close();
+    bool recovered(); // Whether open() had to repair a file left by a crash
+    bool sync();      // msync the whole mapping
+
+    bool insert(int val, int threadID); // Insert 'val' in ascending order; false if the file is full
+    bool remove(int val, int threadID); // Remove 'val' if it exists
+    bool contains(int val, int threadID); // Check if 'val' is in the list
+
+    void scanAndReclaim(); // Scan and Reclaim Memory
+
+    void printList(); // Print the list contents in ascending order
+    int get_length();
+    bool checkList();
+};
+
+#endif
@@ -0,0 +1,280 @@
+#include "range-list.hpp"
+
+#include <climits>
+
+RangeList::Node::Node(int lo, int hi, Node* nxt)
+    : lo(lo), hi(hi), next(nxt), removed(false) {}
+
+RangeList::RangeList() : length(0), intervals(0), operationCounter(0) {
+    head = new Node(INT_MIN, INT_MIN); // Sentinel; its bounds are never read
+}
+
+RangeList::~RangeList() {
+    Node* curr = head;
+    while (curr) {
+        Node* temp = curr;
+        curr = curr->next;
+        delete temp;
+    }
+}
+
+bool RangeList::validate(Node* pred, Node* curr) {
+    return (!pred->removed && !(curr && curr->removed) && pred->next == curr);
+}
+
+void RangeList::findWindow(int val, int threadID, Node*& pred, Node*& curr) {
+    while (true) {
+        // Publish each node before following it, then re-check that it is
+        // still linked behind a live predecessor; otherwise restart.
+        int slot = 0;
+        pred = head;
+        curr = pred->next;
+        AccessedPointers::store(threadID, curr, slot);
+        if (pred->next != curr) {
+            continue;
+        }
+
+        bool restart = false;
+        while (curr && curr->hi < val) {
+            Node* next = curr->next;
+            slot = 1 - slot;
+            AccessedPointers::store(threadID, next, slot);
+            if (curr->removed || curr->next != next) {
+                restart = true;
+                break;
+            }
+            pred = curr;
+            curr = next;
+        }
+
+        if (!restart) {
+            return;
+        }
+    }
+}
+
+void RangeList::countOperation() {
+    if (operationCounter.fetch_add(1, std::memory_order_relaxed) + 1 >= intervals) {
+        scanAndReclaim();
+        operationCounter.fetch_sub(intervals, std::memory_order_relaxed);
+    }
+}
+
+void RangeList::scanAndReclaim() {
+    retireList.scanAndReclaim();
+}
+
+bool RangeList::insert(int val, int threadID) {
+    while (true) {
+        Node* pred;
+        Node* curr;
+        findWindow(val, threadID, pred, curr);
+
+        {
+            std::unique_lock<std::mutex> lockPred(pred->m);
+            std::unique_lock<std::mutex> lockCurr;
+            if (curr) {
+                lockCurr = std::unique_lock<std::mutex>(curr->m);
+            }
+
+            if (!validate(pred, curr)) {
+                AccessedPointers::reset(threadID);
+                continue;
+            }
+
+            // 'curr' is the first run with hi >= val
+            if (curr && curr->lo <= val) {
+                AccessedPointers::reset(threadID);
+                return false;
+            }
+
+            // pred->hi < val < curr->lo, so neither bound can overflow
+            bool joinsPred = (pred != head && pred->hi + 1 == val);
+            bool joinsCurr = (curr && curr->lo - 1 == val);
+
+            if (joinsPred && joinsCurr) {
+                // Merge: widen 'pred' over 'curr' before unlinking it
+                pred->hi = curr->hi.load();
+                curr->removed = true;
+                pred->next = curr->next;
+                retireList.retire(curr);
+                intervals.fetch_sub(1, std::memory_order_relaxed);
+            } else if (joinsPred) {
+                pred->hi = val;
+            } else if (joinsCurr) {
+                curr->lo = val;
+            } else {
+                pred->next = new Node(val, val, curr);
+                intervals.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        AccessedPointers::reset(threadID);
+        length.fetch_add(1, std::memory_order_relaxed);
+        countOperation();
+        return true;
+    }
+}
+
+void RangeList::insertRange(int lo, int hi, int threadID) {
+    if (lo > hi) {
+        return;
+    }
+
+    while (true) {
+        Node* pred;
+        Node* curr;
+        // Start at the first run that overlaps or touches [lo, hi]
+        findWindow(lo == INT_MIN ? lo : lo - 1, threadID, pred, curr);
+
+        long long added = 0;
+        {
+            std::unique_lock<std::mutex> lockPred(pred->m);
+            std::unique_lock<std::mutex> lockCurr;
+            if (curr) {
+                lockCurr = std::unique_lock<std::mutex>(curr->m);
+            }
+
+            if (!validate(pred, curr)) {
+                AccessedPointers::reset(threadID);
+                continue;
+            }
+
+            if (!curr || curr->lo > (long long)hi + 1) {
+                pred->next = new Node(lo, hi, curr);
+                intervals.fetch_add(1, std::memory_order_relaxed);
+                added = (long long)hi - lo + 1;
+            } else {
+                if (lo < curr->lo) {
+                    added += (long long)curr->lo - lo;
+                    curr->lo = lo;
+                }
+
+                // Absorb following runs up to 'hi'. They cannot be unlinked
+                // by anyone else while 'curr' is locked.
+                while (curr->hi < hi) {
+                    Node* next = curr->next;
+                    if (!next || next->lo > (long long)hi + 1) {
+                        added += (long long)hi - curr->hi;
+                        curr->hi = hi;
+                        break;
+                    }
+
+                    std::lock_guard<std::mutex> lockNext(next->m);
+                    added += (long long)next->lo - curr->hi - 1;
+                    curr->hi = next->hi.load();
+                    next->removed = true;
+                    curr->next = next->next;
+                    retireList.retire(next);
+                    intervals.fetch_sub(1, std::memory_order_relaxed);
+                }
+            }
+        }
+
+        AccessedPointers::reset(threadID);
+        length.fetch_add(added, std::memory_order_relaxed);
+        countOperation();
+        return;
+    }
+}
+
+bool RangeList::remove(int val, int threadID) {
+    while (true) {
+        Node* pred;
+        Node* curr;
+        findWindow(val, threadID, pred, curr);
+
+        {
+            std::unique_lock<std::mutex> lockPred(pred->m);
+            std::unique_lock<std::mutex> lockCurr;
+            if (curr) {
+                lockCurr = std::unique_lock<std::mutex>(curr->m);
+            }
+
+            if (!validate(pred, curr)) {
+                AccessedPointers::reset(threadID);
+                continue;
+            }
+
+            if (!curr || curr->lo > val) {
+                AccessedPointers::reset(threadID);
+                return false;
+            }
+
+            int lo = curr->lo;
+            int hi = curr->hi;
+            if (lo == hi) {
+                curr->removed = true;
+                pred->next = curr->next;
+                retireList.retire(curr);
+                intervals.fetch_sub(1, std::memory_order_relaxed);
+            } else if (val == lo) {
+                curr->lo = val + 1;
+            } else if (val == hi) {
+                curr->hi = val - 1;
+            } else {
+                // Split: link the upper part before narrowing 'curr'
+                curr->next = new Node(val + 1, hi, curr->next);
+                curr->hi = val - 1;
+                intervals.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        AccessedPointers::reset(threadID);
+        length.fetch_sub(1, std::memory_order_relaxed);
+        countOperation();
+        return true;
+    }
+}
+
+bool RangeList::contains(int val, int threadID) {
+    while (true) {
+        Node* pred;
+        Node* curr;
+        findWindow(val, threadID, pred, curr);
+
+        // A removed run may have been merged into its predecessor
+        if (curr && curr->removed) {
+            continue;
+        }
+
+        bool found = (curr && curr->lo <= val);
+        AccessedPointers::reset(threadID);
+        return found;
+    }
+}
+
+void RangeList::printList() {
+    Node* curr = head->next;
+    while (curr) {
+        if (!curr->removed) {
+            std::cout << "[" << curr->lo << ", " << curr->hi << "] ";
+        }
+        curr = curr->next;
+    }
+    std::cout << std::endl;
+}
+
+long long RangeList::get_length() {
+    return length;
+}
+
+int RangeList::get_intervals() {
+    return intervals;
+}
+
+bool RangeList::checkList() {
+    Node* prev = nullptr;
+    Node* curr = head->next;
+    while (curr) {
+        if (curr->lo > curr->hi) {
+            return false;
+        }
+        if (prev && curr->lo <= (long long)prev->hi + 1) {
+            return false;
+        }
+        prev = curr;
+        curr = curr->next;
+    }
+    return true;
+}
@@ -0,0 +1,57 @@
+#ifndef RANGE_LIST_H
+#define RANGE_LIST_H
+
+#include <iostream>
+#include <mutex>
+#include <atomic>
+
+#include "reclamation.hpp"
+
+// ------------------------------------------------------
+// Interval-Compressed Lazy List (range set)
+// ------------------------------------------------------
+// Each node holds a maximal run [lo, hi] of present keys; runs never
+// overlap or touch. Inserts only widen runs and removes only narrow or
+// split them, and a run absorbed by a merge is widened into its
+// predecessor before it is unlinked, so unlocked readers never miss a
+// key that stayed present for their whole traversal.
+class RangeList {
+private:
+    struct Node {
+        std::atomic<int> lo;
+        std::atomic<int> hi;
+        Node* next;
+        mutable std::mutex m; // Protects this node
+        bool removed;         // 'true' if this node is logically removed
+
+        Node(int lo, int hi, Node* nxt = nullptr);
+    };
+
+    Node* head; // Sentinel node: never removed
+    RetireList<Node> retireList; // Nodes waiting to be freed
+    std::atomic<long long> length; // Number of keys; a run can hold more than INT_MAX
+    std::atomic<int> intervals; // Number of nodes
+    std::atomic<int> operationCounter;
+
+    bool validate(Node* pred, Node* curr);
+    void findWindow(int val, int threadID, Node*& pred, Node*& curr); // 'curr' is the first run with hi >= val
+    void countOperation();
+
+public:
+    RangeList();
+    ~RangeList();
+
+    bool insert(int val, int threadID); // Insert 'val'; false if already present
+    void insertRange(int lo, int hi, int threadID); // Insert every key in [lo, hi]
+    bool remove(int val, int threadID); // Remove 'val', splitting its run if needed
+    bool contains(int val, int threadID); // Check if 'val' is in the set
+
+    void scanAndReclaim(); // Scan and Reclaim Memory
+
+    void printList(); // Print the runs in ascending order
+    long long get_length();
+    int get_intervals();
+    bool checkList();
+};
+
+#endif
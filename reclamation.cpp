@@ -0,0 +1,28 @@
+#include "reclamation.hpp"
+
+std::atomic<const void*> AccessedPointers::table[MAX_THREADS][ACCESSED_PTRS_PER_THREAD];
+
+void AccessedPointers::store(int threadID, const void* node, int index) {
+    table[threadID][index].store(node, std::memory_order_release);
+}
+
+void AccessedPointers::reset(int threadID) {
+    for (int i = 0; i < ENCLOSING_PTR_INDEX; i++) {
+        table[threadID][i].store(nullptr, std::memory_order_release);
+    }
+}
+
+void AccessedPointers::clear(int threadID, int index) {
+    table[threadID][index].store(nullptr, std::memory_order_release);
+}
+
+bool AccessedPointers::isAccessed(const void* node) {
+    for (int i = 0; i < MAX_THREADS; ++i) {
+        for (int j = 0; j < ACCESSED_PTRS_PER_THREAD; j++) {
+            if (table[i][j].load(std::memory_order_acquire) == node) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
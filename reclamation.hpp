@@ -0,0 +1,123 @@
+#ifndef RECLAMATION_H
+#define RECLAMATION_H
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define MAX_THREADS 8
+#define ACCESSED_PTRS_PER_THREAD 4
+#define ENCLOSING_PTR_INDEX 2 // Protects a container object while a nested list walks with slots 0 and 1
+#define CURSOR_PTR_INDEX 3 // Protects an open cursor's position between its calls
+
+// ------------------------------------------------------
+// Accessed Pointers (hazard pointers shared by every container)
+// ------------------------------------------------------
+class AccessedPointers {
+public:
+    static void store(int threadID, const void* node, int index);
+    static void reset(int threadID); // Clears the traversal slots, not ENCLOSING_PTR_INDEX or CURSOR_PTR_INDEX
+    static void clear(int threadID, int index);
+    static bool isAccessed(const void* node);
+
+private:
+    static std::atomic<const void*> table[MAX_THREADS][ACCESSED_PTRS_PER_THREAD];
+};
+
+// ------------------------------------------------------
+// Retire List: unlinked nodes waiting until no thread accesses them
+// ------------------------------------------------------
+template <typename Node>
+class RetireList {
+public:
+    // Holds off reclamation for a whole-list walk that cannot publish
+    // every node it visits (dumps, scans, multi-list merges)
+    class ScanGuard {
+    public:
+        explicit ScanGuard(RetireList& list) : list(list) { list.scans.fetch_add(1); }
+        ~ScanGuard() { list.scans.fetch_sub(1); }
+
+    private:
+        RetireList& list;
+    };
+
+    RetireList() : scans(0), release([](Node* node) { delete node; }) {}
+
+    // For nodes that are not heap allocated, e.g. slots in a mapped file
+    explicit RetireList(std::function<void(Node*)> release) : scans(0), release(std::move(release)) {}
+
+    ~RetireList() {
+        for (Node* node : nodes) {
+            release(node);
+        }
+    }
+
+    // Keep retired nodes for which 'hold' returns true until a later scan
+    void setHold(std::function<bool(Node*)> hold) {
+        std::lock_guard<std::mutex> lock(m);
+        this->hold = std::move(hold);
+    }
+
+    void retire(Node* node) {
+        std::lock_guard<std::mutex> lock(m);
+        nodes.push_back(node);
+    }
+
+    void retire(const std::vector<Node*>& batch) {
+        std::lock_guard<std::mutex> lock(m);
+        nodes.insert(nodes.end(), batch.begin(), batch.end());
+    }
+
+    void scanAndReclaim() {
+        std::lock_guard<std::mutex> lock(m);
+        if (scans.load() > 0) {
+            return; // Every retired node may still be reached by a scan
+        }
+        std::vector<Node*> remaining;
+
+        for (Node* node : nodes) {
+            if (!AccessedPointers::isAccessed(node) && !(hold && hold(node))) {
+                release(node); // Safe to free
+            } else {
+                remaining.push_back(node);
+            }
+        }
+
+        nodes = std::move(remaining);
+    }
+
+    // Wait until no scan is walking nodes this list may free
+    void waitForScans() {
+        while (scans.load() > 0) {
+            std::this_thread::yield();
+        }
+    }
+
+    // Free every retired node; only when no thread can still access them
+    void releaseAll() {
+        std::lock_guard<std::mutex> lock(m);
+        for (Node* node : nodes) {
+            release(node);
+        }
+        nodes.clear();
+    }
+
+    template <typename F>
+    void forEach(F f) {
+        std::lock_guard<std::mutex> lock(m);
+        for (Node* node : nodes) {
+            f(node);
+        }
+    }
+
+private:
+    std::mutex m;
+    std::vector<Node*> nodes;
+    std::atomic<int> scans;
+    std::function<void(Node*)> release;
+    std::function<bool(Node*)> hold;
+};
+
+#endif
@@ -0,0 +1,223 @@
+#include "replicated-list.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <sched.h>
+#include <unistd.h>
+
+#define SLOT_EMPTY 0
+#define SLOT_POSTED 1
+#define SLOT_DONE 2
+
+ReplicatedList::Replica::Replica() : applied(0) {
+    for (Slot& slot : slots) {
+        slot.state.store(SLOT_EMPTY);
+    }
+}
+
+// Map each CPU to its node from sysfs; a machine without that information
+// is treated as a single node
+std::vector<int> ReplicatedList::detectNodes(int& numNodes) {
+    std::vector<int> cpuNode;
+    numNodes = 0;
+    for (int node = 0;; ++node) {
+        std::ifstream in("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        if (!in) {
+            break;
+        }
+        numNodes = node + 1;
+        std::string list;
+        std::getline(in, list);
+        std::stringstream ranges(list);
+        std::string range;
+        while (std::getline(ranges, range, ',')) {
+            if (range.empty()) {
+                continue;
+            }
+            size_t dash = range.find('-');
+            int lo = std::stoi(range.substr(0, dash));
+            int hi = (dash == std::string::npos) ? lo : std::stoi(range.substr(dash + 1));
+            if (hi >= (int)cpuNode.size()) {
+                cpuNode.resize(hi + 1, 0);
+            }
+            for (int cpu = lo; cpu <= hi; ++cpu) {
+                cpuNode[cpu] = node;
+            }
+        }
+    }
+    numNodes = std::max(numNodes, 1);
+    return cpuNode;
+}
+
+ReplicatedList::ReplicatedList(int numReplicas)
+    : log(new LogEntry[REPLICATED_LOG_SIZE]), tail(0) {
+    int numNodes;
+    cpuNode = detectNodes(numNodes);
+    if (numReplicas <= 0) {
+        numReplicas = numNodes;
+    }
+    numReplicas = std::min(numReplicas, REPLICATED_MAX_REPLICAS);
+    for (int i = 0; i < numReplicas; ++i) {
+        replicas.emplace_back(new Replica());
+    }
+    for (uint64_t i = 0; i < REPLICATED_LOG_SIZE; ++i) {
+        log[i].filled.store(0);
+    }
+}
+
+ReplicatedList::Replica& ReplicatedList::localReplica() {
+    int cpu = sched_getcpu();
+    int node = (cpu >= 0 && cpu < (int)cpuNode.size()) ? cpuNode[cpu] : 0;
+    return *replicas[node % replicas.size()];
+}
+
+// Apply log entries up to 'upTo' to a replica whose combiner lock is held,
+// recording results for the caller's own batch
+void ReplicatedList::apply(Replica& replica, uint64_t upTo, int threadID, uint64_t batchStart,
+                           Slot** batch, uint64_t batchSize) {
+    for (uint64_t pos = replica.applied.load(); pos < upTo; ++pos) {
+        LogEntry& entry = log[pos % REPLICATED_LOG_SIZE];
+        while (entry.filled.load(std::memory_order_acquire) != pos + 1) {
+            std::this_thread::yield(); // Reserved by a writer that is still filling it
+        }
+        bool result = true;
+        if (entry.op == Op::Insert) {
+            replica.list.insert(entry.key, threadID);
+        } else {
+            result = replica.list.remove(entry.key, threadID);
+        }
+        if (batch && pos >= batchStart && pos < batchStart + batchSize) {
+            batch[pos - batchStart]->result = result;
+        }
+        replica.applied.store(pos + 1, std::memory_order_release);
+    }
+}
+
+// Reserve 'count' consecutive log entries. An entry can be reused once every
+// replica has applied it, so a full log is drained by bringing the lagging
+// replicas up to date; a replica whose lock is busy is already moving.
+// 'own' is the replica whose combiner lock the caller holds.
+uint64_t ReplicatedList::reserve(Replica& own, uint64_t count, int threadID) {
+    while (true) {
+        uint64_t start = tail.load();
+        uint64_t oldest = start;
+        for (auto& replica : replicas) {
+            oldest = std::min(oldest, replica->applied.load());
+        }
+        if (start + count - oldest <= REPLICATED_LOG_SIZE) {
+            if (tail.compare_exchange_weak(start, start + count)) {
+                return start;
+            }
+            continue;
+        }
+        apply(own, start, threadID);
+        for (auto& replica : replicas) {
+            if (replica.get() != &own && replica->applied.load() == oldest &&
+                replica->combiner.try_lock()) {
+                apply(*replica, start, threadID);
+                replica->combiner.unlock();
+            }
+        }
+        std::this_thread::yield();
+    }
+}
+
+// Called with the replica's combiner lock held
+void ReplicatedList::combine(Replica& replica, int threadID) {
+    Slot* batch[MAX_THREADS];
+    uint64_t count = 0;
+    for (Slot& slot : replica.slots) {
+        if (slot.state.load(std::memory_order_acquire) == SLOT_POSTED) {
+            batch[count++] = &slot;
+        }
+    }
+    if (count == 0) {
+        return;
+    }
+
+    uint64_t start = reserve(replica, count, threadID);
+    for (uint64_t i = 0; i < count; ++i) {
+        LogEntry& entry = log[(start + i) % REPLICATED_LOG_SIZE];
+        entry.op = batch[i]->op;
+        entry.key = batch[i]->key;
+        entry.filled.store(start + i + 1, std::memory_order_release);
+    }
+    apply(replica, start + count, threadID, start, batch, count);
+    for (uint64_t i = 0; i < count; ++i) {
+        batch[i]->state.store(SLOT_DONE, std::memory_order_release);
+    }
+}
+
+bool ReplicatedList::update(Op op, int val, int threadID) {
+    Replica& replica = localReplica();
+    Slot& slot = replica.slots[threadID];
+    slot.op = op;
+    slot.key = val;
+    slot.state.store(SLOT_POSTED, std::memory_order_release);
+
+    // Either combine for every local thread or wait for a combiner to
+    // complete this slot
+    while (slot.state.load(std::memory_order_acquire) != SLOT_DONE) {
+        if (replica.combiner.try_lock()) {
+            combine(replica, threadID);
+            replica.combiner.unlock();
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    slot.state.store(SLOT_EMPTY, std::memory_order_relaxed);
+    return slot.result;
+}
+
+// Wait until everything logged before this call is applied; updates that
+// completed before it are therefore visible to the read that follows. A
+// busy combiner is already moving 'applied' forward, so the reader only
+// takes the lock when it is free.
+void ReplicatedList::syncReplica(Replica& replica, int threadID) {
+    uint64_t upTo = tail.load();
+    while (replica.applied.load(std::memory_order_acquire) < upTo) {
+        if (replica.combiner.try_lock()) {
+            apply(replica, upTo, threadID);
+            replica.combiner.unlock();
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void ReplicatedList::insert(int val, int threadID) {
+    update(Op::Insert, val, threadID);
+}
+
+bool ReplicatedList::remove(int val, int threadID) {
+    return update(Op::Remove, val, threadID);
+}
+
+bool ReplicatedList::contains(int val, int threadID) {
+    Replica& replica = localReplica();
+    syncReplica(replica, threadID);
+    return replica.list.contains(val, threadID);
+}
+
+int ReplicatedList::get_replicas() {
+    return (int)replicas.size();
+}
+
+int ReplicatedList::get_length() {
+    return localReplica().list.get_length();
+}
+
+void ReplicatedList::printList(int threadID) {
+    Replica& replica = localReplica();
+    syncReplica(replica, threadID);
+    replica.list.printList();
+}
+
+bool ReplicatedList::checkList(int threadID) {
+    Replica& replica = localReplica();
+    syncReplica(replica, threadID);
+    return replica.list.checkList();
+}
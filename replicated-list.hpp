@@ -0,0 +1,85 @@
+#ifndef REPLICATED_LIST_H
+#define REPLICATED_LIST_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+
+#include "concurrent-linked-list.hpp"
+#include "reclamation.hpp"
+
+#define REPLICATED_LOG_SIZE 4096   // Entries in the shared operation log
+#define REPLICATED_MAX_REPLICAS 8
+
+// ------------------------------------------------------
+// Node-Replicated List
+// ------------------------------------------------------
+// One MarkedList replica per NUMA node, kept identical by a shared
+// operation log. An update is posted in the caller's slot on its local
+// replica. Whichever local thread holds the replica's combiner lock
+// gathers every posted update, reserves log entries for them and then
+// applies the log to its replica up to the end of its batch. That replays
+// other nodes' updates too, so all replicas apply one sequence and return
+// the same results. A read waits until the local replica has applied the
+// log tail it saw on entry, applying the log itself only if no combiner
+// is at work, and then runs on the replica without locks. Replica nodes
+// are allocated by whichever thread applies the log, which is not always
+// on the replica's node: when the log is full, the writer brings lagging
+// replicas up to date itself so an idle node never stalls the others.
+// Memory placement is therefore left to the OS.
+class ReplicatedList {
+private:
+    enum class Op : uint8_t { Insert, Remove };
+
+    struct LogEntry {
+        std::atomic<uint64_t> filled; // Log position + 1 once 'op' and 'key' are written
+        Op op;
+        int key;
+    };
+
+    struct alignas(64) Slot {
+        std::atomic<int> state; // SLOT_EMPTY, SLOT_POSTED or SLOT_DONE
+        Op op;
+        int key;
+        bool result;
+    };
+
+    struct alignas(64) Replica {
+        MarkedList list;
+        std::mutex combiner;           // Held while applying the log to 'list'
+        std::atomic<uint64_t> applied; // Log position 'list' is current up to
+        Slot slots[MAX_THREADS];       // Updates posted by threads on this node
+
+        Replica();
+    };
+
+    std::unique_ptr<LogEntry[]> log;
+    alignas(64) std::atomic<uint64_t> tail; // Next free log position
+    std::vector<std::unique_ptr<Replica>> replicas;
+    std::vector<int> cpuNode; // NUMA node of each CPU
+
+    Replica& localReplica();
+    bool update(Op op, int val, int threadID);
+    void combine(Replica& replica, int threadID);
+    uint64_t reserve(Replica& own, uint64_t count, int threadID);
+    void apply(Replica& replica, uint64_t upTo, int threadID, uint64_t batchStart = 0,
+               Slot** batch = nullptr, uint64_t batchSize = 0);
+    void syncReplica(Replica& replica, int threadID);
+    static std::vector<int> detectNodes(int& numNodes);
+
+public:
+    explicit ReplicatedList(int numReplicas = 0); // 0 for one replica per NUMA node
+
+    void insert(int val, int threadID); // Insert 'val' in ascending order
+    bool remove(int val, int threadID); // Remove 'val' if it exists
+    bool contains(int val, int threadID); // Check if 'val' is in the list
+
+    int get_replicas();
+    int get_length(); // Length of the calling thread's replica, which may lag the log
+    void printList(int threadID);
+    bool checkList(int threadID); // Check the local replica after bringing it up to date
+};
+
+#endif
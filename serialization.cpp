@@ -0,0 +1,253 @@
+#include "serialization.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+static uint32_t crcTable[256];
+
+static bool buildCrcTable() {
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; ++k) {
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        crcTable[i] = c;
+    }
+    return true;
+}
+
+static const bool crcTableReady = buildCrcTable();
+
+uint32_t crc32(const uint8_t* data, size_t len, uint32_t crc) {
+    (void)crcTableReady;
+    crc = ~crc;
+    for (size_t i = 0; i < len; ++i) {
+        crc = crcTable[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+void putFixed(uint8_t* out, uint64_t val, int bytes) {
+    for (int i = 0; i < bytes; ++i) {
+        out[i] = (uint8_t)(val >> (8 * i));
+    }
+}
+
+uint64_t getFixed(const uint8_t* in, int bytes) {
+    uint64_t val = 0;
+    for (int i = 0; i < bytes; ++i) {
+        val |= (uint64_t)in[i] << (8 * i);
+    }
+    return val;
+}
+
+bool writeAll(int fd, const void* data, size_t len) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    while (len > 0) {
+        ssize_t n = ::write(fd, bytes, len);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        bytes += n;
+        len -= n;
+    }
+    return true;
+}
+
+bool readAll(int fd, void* data, size_t len) {
+    uint8_t* bytes = static_cast<uint8_t*>(data);
+    while (len > 0) {
+        ssize_t n = ::read(fd, bytes, len);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        bytes += n;
+        len -= n;
+    }
+    return true;
+}
+
+FdWriter::FdWriter(int fd) : fd(fd), ok(true), crc(0) {
+    buffer.reserve(IO_BUFFER_SIZE);
+}
+
+void FdWriter::flush() {
+    crc = crc32(buffer.data(), buffer.size(), crc);
+    ok = ok && writeAll(fd, buffer.data(), buffer.size());
+    buffer.clear();
+}
+
+void FdWriter::put(const void* data, size_t len) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    while (len > 0) {
+        size_t n = std::min(len, IO_BUFFER_SIZE - buffer.size());
+        buffer.insert(buffer.end(), bytes, bytes + n);
+        bytes += n;
+        len -= n;
+        if (buffer.size() == IO_BUFFER_SIZE) {
+            flush();
+        }
+    }
+}
+
+void FdWriter::putVarint(uint64_t val) {
+    uint8_t bytes[10];
+    int n = 0;
+    while (val >= 0x80) {
+        bytes[n++] = (uint8_t)(val | 0x80);
+        val >>= 7;
+    }
+    bytes[n++] = (uint8_t)val;
+    put(bytes, n);
+}
+
+bool FdWriter::finish() {
+    flush();
+    uint8_t trailer[4];
+    putFixed(trailer, crc, 4);
+    buffer.assign(trailer, trailer + 4);
+    flush();
+    return ok;
+}
+
+FdReader::FdReader(int fd) : fd(fd), crc(0), buffer(IO_BUFFER_SIZE), pos(0), len(0) {}
+
+bool FdReader::fill() {
+    while (true) {
+        ssize_t n = ::read(fd, buffer.data(), buffer.size());
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        pos = 0;
+        len = n;
+        return true;
+    }
+}
+
+bool FdReader::getRaw(void* data, size_t n) {
+    uint8_t* bytes = static_cast<uint8_t*>(data);
+    while (n > 0) {
+        if (pos == len && !fill()) {
+            return false;
+        }
+        size_t take = std::min(n, len - pos);
+        std::memcpy(bytes, buffer.data() + pos, take);
+        pos += take;
+        bytes += take;
+        n -= take;
+    }
+    return true;
+}
+
+bool FdReader::get(void* data, size_t n) {
+    if (!getRaw(data, n)) {
+        return false;
+    }
+    crc = crc32(static_cast<uint8_t*>(data), n, crc);
+    return true;
+}
+
+bool FdReader::getVarint(uint64_t& val) {
+    val = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        uint8_t byte;
+        if (!get(&byte, 1)) {
+            return false;
+        }
+        val |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false; // Over-long varint
+}
+
+bool FdReader::finish() {
+    uint8_t trailer[4];
+    if (!getRaw(trailer, 4)) {
+        return false;
+    }
+    return getFixed(trailer, 4) == crc;
+}
+
+SnapshotWriter::SnapshotWriter(int fd) : writer(fd), prev(INT_MIN) {
+    writer.put(SNAPSHOT_MAGIC, 4);
+    uint8_t version = SNAPSHOT_VERSION;
+    writer.put(&version, 1);
+    block.reserve(SNAPSHOT_BLOCK_KEYS);
+}
+
+void SnapshotWriter::writeBlock() {
+    writer.putVarint(block.size());
+    for (uint64_t delta : block) {
+        writer.putVarint(delta);
+    }
+    block.clear();
+}
+
+void SnapshotWriter::add(int key) {
+    block.push_back((uint64_t)(key - prev));
+    prev = key;
+    if (block.size() == SNAPSHOT_BLOCK_KEYS) {
+        writeBlock();
+    }
+}
+
+bool SnapshotWriter::finish() {
+    if (!block.empty()) {
+        writeBlock();
+    }
+    writer.putVarint(0);
+    return writer.finish();
+}
+
+SnapshotReader::SnapshotReader(int fd)
+    : reader(fd), blockLeft(0), prev(INT_MIN), ok(true), ended(false) {
+    char magic[4];
+    uint8_t version;
+    if (!reader.get(magic, 4) || std::memcmp(magic, SNAPSHOT_MAGIC, 4) != 0 ||
+        !reader.get(&version, 1) || version != SNAPSHOT_VERSION) {
+        ok = false;
+    }
+}
+
+bool SnapshotReader::next(int& key) {
+    if (!ok || ended) {
+        return false;
+    }
+    if (blockLeft == 0) {
+        if (!reader.getVarint(blockLeft)) {
+            ok = false;
+            return false;
+        }
+        if (blockLeft == 0) {
+            ended = true;
+            return false;
+        }
+    }
+    uint64_t delta;
+    if (!reader.getVarint(delta) || delta > (uint64_t)INT_MAX - prev) {
+        ok = false;
+        return false;
+    }
+    blockLeft--;
+    prev += delta;
+    key = (int)prev;
+    return true;
+}
+
+bool SnapshotReader::finish() {
+    return ok && ended && reader.finish();
+}
@@ -0,0 +1,101 @@
+#ifndef SERIALIZATION_H
+#define SERIALIZATION_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// ------------------------------------------------------
+// Binary Snapshot Format
+// ------------------------------------------------------
+// "MLST" | format version (1 byte) | blocks | CRC-32 (4 bytes, little endian)
+// A block is a varint key count followed by that many varint deltas; a
+// zero-length block ends the stream. Keys ascend and each delta is taken
+// from the previous key (from INT_MIN for the first), so it is never
+// negative. The CRC covers every byte before it.
+#define SNAPSHOT_MAGIC "MLST"
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_BLOCK_KEYS 4096
+#define IO_BUFFER_SIZE (1 << 16)
+
+uint32_t crc32(const uint8_t* data, size_t len, uint32_t crc = 0);
+
+// Little-endian fixed-width fields of 'bytes' bytes
+void putFixed(uint8_t* out, uint64_t val, int bytes);
+uint64_t getFixed(const uint8_t* in, int bytes);
+
+// Unbuffered I/O that retries short transfers and EINTR
+bool writeAll(int fd, const void* data, size_t len);
+bool readAll(int fd, void* data, size_t len);
+
+// Buffered writer that keeps a running CRC of everything written
+class FdWriter {
+public:
+    explicit FdWriter(int fd);
+
+    void put(const void* data, size_t len);
+    void putVarint(uint64_t val);
+    bool finish(); // Append the CRC and flush; false on any write error
+
+private:
+    int fd;
+    bool ok;
+    uint32_t crc;
+    std::vector<uint8_t> buffer;
+
+    void flush();
+};
+
+// Buffered reader that keeps a running CRC of everything read
+class FdReader {
+public:
+    explicit FdReader(int fd);
+
+    bool get(void* data, size_t len);
+    bool getVarint(uint64_t& val);
+    bool finish(); // Read the trailing CRC and compare it
+
+private:
+    int fd;
+    uint32_t crc;
+    std::vector<uint8_t> buffer;
+    size_t pos;
+    size_t len;
+
+    bool fill();
+    bool getRaw(void* data, size_t n);
+};
+
+// Encoder for the snapshot format; keys must be added in ascending order
+class SnapshotWriter {
+public:
+    explicit SnapshotWriter(int fd);
+
+    void add(int key);
+    bool finish(); // End the stream and append the CRC
+
+private:
+    FdWriter writer;
+    std::vector<uint64_t> block; // One block of deltas, since a block starts with its size
+    long long prev;
+
+    void writeBlock();
+};
+
+// Decoder for the snapshot format
+class SnapshotReader {
+public:
+    explicit SnapshotReader(int fd);
+
+    bool next(int& key); // False at the end of the stream or on a decoding error
+    bool finish();       // Whether the stream ended cleanly with a matching CRC
+
+private:
+    FdReader reader;
+    uint64_t blockLeft;
+    long long prev;
+    bool ok;
+    bool ended;
+};
+
+#endif
@@ -0,0 +1,526 @@
+#include "shared-list.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SHARED_ATTACH_TIMEOUT_MS 5000 // Longest open() waits for another process to attach
+
+static void initMutex(pthread_mutex_t* m) {
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init(m, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+// Returns true if the previous owner died while holding the lock
+static bool lockMutex(pthread_mutex_t* m) {
+    if (pthread_mutex_lock(m) == EOWNERDEAD) {
+        pthread_mutex_consistent(m);
+        return true;
+    }
+    return false;
+}
+
+// Start time of 'pid' in clock ticks since boot (field 22 of
+// /proc/<pid>/stat), or 0 if it cannot be read
+static uint64_t processStartTime(pid_t pid) {
+    char path[32];
+    std::snprintf(path, sizeof(path), "/proc/%d/stat", (int)pid);
+    int in = ::open(path, O_RDONLY);
+    if (in < 0) {
+        return 0;
+    }
+    char buffer[1024];
+    ssize_t n = read(in, buffer, sizeof(buffer) - 1);
+    ::close(in);
+    if (n <= 0) {
+        return 0;
+    }
+    buffer[n] = '\0';
+
+    // Field 2 is the command name in parentheses and may contain spaces
+    const char* field = std::strrchr(buffer, ')');
+    for (int i = 2; field && i < 22; ++i) {
+        field = std::strchr(field + 1, ' ');
+    }
+    return field ? std::strtoull(field + 1, nullptr, 10) : 0;
+}
+
+// 'startTime' tells the slot owner apart from a later process with the same pid
+static bool processAlive(pid_t pid, uint64_t startTime) {
+    if (kill(pid, 0) != 0 && errno == ESRCH) {
+        return false;
+    }
+    uint64_t current = processStartTime(pid);
+    return startTime == 0 || current == 0 || current == startTime;
+}
+
+// Take the object's exclusive lock; false if a live process keeps it too long
+static bool lockObject(int fd) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(SHARED_ATTACH_TIMEOUT_MS);
+    while (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+        if (errno != EWOULDBLOCK || std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+static std::string objectName(const std::string& name) {
+    return (!name.empty() && name[0] == '/') ? name : "/" + name;
+}
+
+SharedList::NodeLock::NodeLock(SharedList* list, Node* node) : node(nullptr) {
+    acquire(list, node);
+}
+
+SharedList::NodeLock::~NodeLock() {
+    if (node) {
+        pthread_mutex_unlock(&node->m);
+    }
+}
+
+void SharedList::NodeLock::acquire(SharedList* list, Node* target) {
+    if (lockMutex(&target->m)) {
+        list->repair(target);
+    }
+    node = target;
+}
+
+SharedList::SharedList()
+    : fd(-1), base(nullptr), header(nullptr), head(nullptr), self(nullptr), operationCounter(0) {}
+
+SharedList::~SharedList() {
+    close();
+}
+
+SharedList::Node* SharedList::at(uint64_t offset) const {
+    return offset ? reinterpret_cast<Node*>(base + offset) : nullptr;
+}
+
+// Slots start on the first cache line after the header
+uint64_t SharedList::nodeArea() {
+    return 64 * ((sizeof(Header) + 63) / 64);
+}
+
+uint64_t SharedList::offsetOf(const Node* node) const {
+    return node ? reinterpret_cast<const char*>(node) - base : 0;
+}
+
+bool SharedList::open(const std::string& objName, size_t capacity) {
+    if (base) {
+        return false;
+    }
+    name = objectName(objName);
+    fd = shm_open(name.c_str(), O_RDWR | O_CREAT, 0600);
+    if (fd < 0) {
+        return false;
+    }
+
+    // Whoever holds the lock and finds the object not ready initializes it;
+    // the kernel drops the lock of a process that dies half way
+    struct stat st;
+    if (!lockObject(fd) || fstat(fd, &st) != 0) {
+        close();
+        return false;
+    }
+    if (st.st_size != 0) {
+        capacity = st.st_size;
+    } else if (ftruncate(fd, capacity) != 0) {
+        close();
+        return false;
+    }
+    if (capacity < nodeArea() + 2 * sizeof(Node)) {
+        close();
+        return false;
+    }
+
+    void* mapping = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+        close();
+        return false;
+    }
+    base = static_cast<char*>(mapping);
+    header = reinterpret_cast<Header*>(base);
+
+    if (!header->ready.load(std::memory_order_acquire)) {
+        initialize(capacity);
+    } else if (std::memcmp(header->magic, SHARED_MAGIC, 8) != 0 ||
+               header->version != SHARED_VERSION || header->capacity != capacity) {
+        close();
+        return false;
+    }
+    flock(fd, LOCK_UN);
+
+    head = at(header->head);
+    if (!claimSlot()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+// Called with the object locked; any state a dead creator left is overwritten
+void SharedList::initialize(size_t capacity) {
+    std::memcpy(header->magic, SHARED_MAGIC, 8);
+    header->version = SHARED_VERSION;
+    header->capacity = capacity;
+    initMutex(&header->allocMutex);
+    initMutex(&header->reclaimMutex);
+    header->head = nodeArea();
+    header->top.store(nodeArea() + sizeof(Node), std::memory_order_relaxed);
+    header->freeList = 0;
+    header->retired = 0;
+    header->length.store(0, std::memory_order_relaxed);
+    for (ProcessSlot& slot : header->processes) {
+        slot.pid.store(0, std::memory_order_relaxed);
+        clearSlot(slot, 0);
+    }
+    Node* sentinel = reinterpret_cast<Node*>(base + header->head);
+    initMutex(&sentinel->m);
+    sentinel->next.store(0, std::memory_order_relaxed);
+    sentinel->value = -1;
+    sentinel->removed.store(0, std::memory_order_relaxed);
+    header->ready.store(1, std::memory_order_release);
+}
+
+void SharedList::close() {
+    if (self) {
+        scanAndReclaim();
+        clearSlot(*self, getpid());
+        self = nullptr;
+    }
+    if (base) {
+        munmap(base, header->capacity);
+        base = nullptr;
+        header = nullptr;
+        head = nullptr;
+    }
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+bool SharedList::destroy(const std::string& objName) {
+    return shm_unlink(objectName(objName).c_str()) == 0;
+}
+
+bool SharedList::claimSlot() {
+    pid_t pid = getpid();
+    uint64_t startTime = processStartTime(pid);
+    for (int pass = 0; pass < 2; ++pass) {
+        for (ProcessSlot& slot : header->processes) {
+            pid_t expected = 0;
+            if (slot.pid.compare_exchange_strong(expected, pid)) {
+                slot.startTime.store(startTime);
+                self = &slot;
+                return true;
+            }
+        }
+        // Every slot is taken; free the ones whose process has died. Slots
+        // are only cleared under reclaimMutex, so a slot claimed again in
+        // the meantime is never cleared.
+        lockMutex(&header->reclaimMutex);
+        for (ProcessSlot& slot : header->processes) {
+            pid_t owner = slot.pid.load();
+            if (owner && !processAlive(owner, slot.startTime.load())) {
+                clearSlot(slot, owner);
+            }
+        }
+        pthread_mutex_unlock(&header->reclaimMutex);
+    }
+    return false;
+}
+
+// The start time is cleared before the slot is released, so a new owner
+// is never checked against the old owner's start time
+void SharedList::clearSlot(ProcessSlot& slot, pid_t pid) {
+    for (auto& thread : slot.accessed) {
+        for (auto& offset : thread) {
+            offset.store(0);
+        }
+    }
+    slot.scans.store(0);
+    slot.startTime.store(0);
+    slot.pid.compare_exchange_strong(pid, 0);
+}
+
+SharedList::Node* SharedList::allocate(int val, uint64_t next) {
+    Node* node = nullptr;
+    lockMutex(&header->allocMutex); // Every free list update is a single store, so a dead owner leaves it intact
+    if (header->freeList) {
+        node = at(header->freeList);
+        header->freeList = node->next.load(std::memory_order_relaxed);
+    } else {
+        uint64_t top = header->top.load(std::memory_order_relaxed);
+        if (top + sizeof(Node) <= header->capacity) {
+            node = at(top);
+            initMutex(&node->m);
+            header->top.store(top + sizeof(Node), std::memory_order_relaxed);
+        }
+    }
+    pthread_mutex_unlock(&header->allocMutex);
+
+    if (node) {
+        node->value = val;
+        node->removed.store(0, std::memory_order_relaxed);
+        node->retireNext = 0;
+        node->next.store(next, std::memory_order_relaxed);
+    }
+    return node;
+}
+
+void SharedList::release(Node* node) {
+    lockMutex(&header->allocMutex);
+    node->next.store(header->freeList, std::memory_order_relaxed);
+    header->freeList = offsetOf(node);
+    pthread_mutex_unlock(&header->allocMutex);
+}
+
+void SharedList::retire(Node* node) {
+    lockMutex(&header->reclaimMutex);
+    node->retireNext = header->retired;
+    header->retired = offsetOf(node);
+    pthread_mutex_unlock(&header->reclaimMutex);
+}
+
+// Called with 'node' locked after its previous owner died. The only
+// multi-step change under a node lock is remove(): mark, then unlink. If
+// the owner died in between, the successor is marked but still linked.
+void SharedList::repair(Node* node) {
+    Node* next = at(node->next.load());
+    if (next && next->removed.load()) {
+        node->next.store(next->next.load(), std::memory_order_release);
+        retire(next);
+    }
+}
+
+bool SharedList::validate(Node* pred, Node* curr) {
+    return (!pred->removed.load() && !(curr && curr->removed.load()) &&
+            at(pred->next.load()) == curr);
+}
+
+void SharedList::resetAccessed(int threadID) {
+    self->accessed[threadID][0].store(0, std::memory_order_release);
+    self->accessed[threadID][1].store(0, std::memory_order_release);
+}
+
+void SharedList::findWindow(int val, int threadID, Node*& pred, Node*& curr) {
+    auto& accessed = self->accessed[threadID];
+    while (true) {
+        // Publish each node's offset before following it, then re-check that
+        // it is still linked behind a live predecessor; otherwise restart.
+        int slot = 0;
+        pred = head;
+        uint64_t offset = pred->next.load(std::memory_order_acquire);
+        accessed[slot].store(offset);
+        if (pred->next.load(std::memory_order_acquire) != offset) {
+            continue;
+        }
+        curr = at(offset);
+
+        bool restart = false;
+        while (curr && curr->value < val) {
+            if (curr->removed.load()) {
+                // A remover unlinks 'curr' before it releases 'pred'; if it
+                // died in between, taking the lock repairs the link, where
+                // a plain restart would meet 'curr' again forever. 'pred'
+                // is still protected in the other slot.
+                NodeLock help(this, pred);
+                restart = true;
+                break;
+            }
+            uint64_t next = curr->next.load(std::memory_order_acquire);
+            slot = 1 - slot;
+            accessed[slot].store(next);
+            if (curr->removed.load() || curr->next.load(std::memory_order_acquire) != next) {
+                restart = true;
+                break;
+            }
+            pred = curr;
+            curr = at(next);
+        }
+
+        if (!restart) {
+            return;
+        }
+    }
+}
+
+void SharedList::countOperation() {
+    int length = get_length();
+    if (operationCounter.fetch_add(1, std::memory_order_relaxed) + 1 >= length) {
+        scanAndReclaim();
+        operationCounter.fetch_sub(length, std::memory_order_relaxed);
+    }
+}
+
+void SharedList::scanAndReclaim() {
+    if (!header) {
+        return;
+    }
+    lockMutex(&header->reclaimMutex);
+
+    std::vector<uint64_t> accessed;
+    bool scanning = false;
+    for (ProcessSlot& slot : header->processes) {
+        pid_t pid = slot.pid.load();
+        if (!pid) {
+            continue;
+        }
+        if (&slot != self && !processAlive(pid, slot.startTime.load())) {
+            clearSlot(slot, pid); // Exited without closing the list
+            continue;
+        }
+        scanning = scanning || slot.scans.load() > 0;
+        for (auto& thread : slot.accessed) {
+            for (auto& offset : thread) {
+                uint64_t value = offset.load();
+                if (value) {
+                    accessed.push_back(value);
+                }
+            }
+        }
+    }
+
+    // Unlink freed nodes from the stack one at a time, so a crash here
+    // leaks at most one slot
+    if (!scanning) {
+        std::sort(accessed.begin(), accessed.end());
+        uint64_t* link = &header->retired;
+        while (*link) {
+            Node* node = at(*link);
+            if (std::binary_search(accessed.begin(), accessed.end(), *link)) {
+                link = &node->retireNext;
+            } else {
+                *link = node->retireNext;
+                release(node);
+            }
+        }
+    }
+    pthread_mutex_unlock(&header->reclaimMutex);
+}
+
+bool SharedList::insert(int val, int threadID) {
+    while (true) {
+        Node* pred;
+        Node* curr;
+        findWindow(val, threadID, pred, curr);
+
+        {
+            NodeLock lockPred(this, pred);
+            NodeLock lockCurr;
+            if (curr) {
+                lockCurr.acquire(this, curr);
+            }
+
+            if (!validate(pred, curr)) {
+                resetAccessed(threadID);
+                continue;
+            }
+
+            Node* newNode = allocate(val, offsetOf(curr));
+            if (!newNode) {
+                resetAccessed(threadID);
+                return false;
+            }
+            pred->next.store(offsetOf(newNode), std::memory_order_release);
+        }
+
+        resetAccessed(threadID);
+        header->length.fetch_add(1, std::memory_order_relaxed);
+        countOperation();
+        return true;
+    }
+}
+
+bool SharedList::remove(int val, int threadID) {
+    while (true) {
+        Node* pred;
+        Node* curr;
+        findWindow(val, threadID, pred, curr);
+
+        {
+            NodeLock lockPred(this, pred);
+            NodeLock lockCurr;
+            if (curr) {
+                lockCurr.acquire(this, curr);
+            }
+
+            if (!validate(pred, curr)) {
+                resetAccessed(threadID);
+                continue;
+            }
+
+            if (!curr || curr->value != val) {
+                resetAccessed(threadID);
+                return false;
+            }
+
+            curr->removed.store(1);
+            pred->next.store(curr->next.load(), std::memory_order_release);
+            retire(curr);
+        }
+
+        resetAccessed(threadID);
+        header->length.fetch_sub(1, std::memory_order_relaxed);
+        countOperation();
+        return true;
+    }
+}
+
+bool SharedList::contains(int val, int threadID) {
+    Node* pred;
+    Node* curr;
+    findWindow(val, threadID, pred, curr);
+
+    bool found = (curr && !curr->removed.load() && curr->value == val);
+    resetAccessed(threadID);
+    return found;
+}
+
+void SharedList::printList() {
+    self->scans.fetch_add(1);
+    for (Node* curr = at(head->next.load()); curr; curr = at(curr->next.load())) {
+        if (!curr->removed.load()) {
+            std::cout << curr->value << " ";
+        }
+    }
+    self->scans.fetch_sub(1);
+    std::cout << std::endl;
+}
+
+int SharedList::get_length() {
+    return header ? (int)header->length.load(std::memory_order_relaxed) : 0;
+}
+
+bool SharedList::checkList() {
+    self->scans.fetch_add(1);
+    bool sorted = true;
+    Node* prev = nullptr;
+    for (Node* curr = at(head->next.load()); curr; curr = at(curr->next.load())) {
+        if (prev && curr->value < prev->value) {
+            sorted = false;
+            break;
+        }
+        prev = curr;
+    }
+    self->scans.fetch_sub(1);
+    return sorted;
+}
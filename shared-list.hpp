@@ -0,0 +1,132 @@
+#ifndef SHARED_LIST_H
+#define SHARED_LIST_H
+
+#include <iostream>
+#include <atomic>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <pthread.h>
+#include <sys/types.h>
+
+#include "reclamation.hpp"
+
+#define SHARED_MAGIC "MLSTSHM"
+#define SHARED_VERSION 2
+#define SHARED_DEFAULT_CAPACITY (256ull << 20) // Object size; pages are only backed once used
+#define SHARED_MAX_PROCESSES 16
+
+// ------------------------------------------------------
+// Shared-Memory Lazy List
+// ------------------------------------------------------
+// The optimistic list in a POSIX shared memory object, so every process
+// that opens the same name serves one copy of the set. Links are offsets
+// into the object, which each process may map at a different address.
+// Locks are robust process-shared mutexes: when a process dies holding a
+// node lock, the next locker finishes the unlink it may have left behind.
+// A search that meets such a node takes its predecessor's lock to do so.
+//
+// Reclamation is shared too. Each process registers a slot holding its
+// threads' hazard offsets, and unlinked nodes go onto a retire stack in
+// the object. Any process may free retired nodes that no live slot
+// protects. Slots of processes that have exited without closing the list
+// are cleared during scans, so a crash never blocks reclamation for good.
+// A slot records its owner's start time next to the pid, so a pid that
+// was reused by an unrelated process does not keep a dead slot alive.
+//
+// open() takes an exclusive flock on the object while it attaches. The
+// process that holds it and finds the object not ready initializes it,
+// so a creator that died half way is simply replaced by the next opener.
+// A crash in the middle of an update can leak one slot or leave the
+// length off by one.
+class SharedList {
+private:
+    struct Node {
+        pthread_mutex_t m;          // Robust and process-shared
+        std::atomic<uint64_t> next; // Offset of the next node, 0 for none; links free slots too
+        uint64_t retireNext;        // Link in the retire stack; 'next' must stay valid for readers
+        int value;
+        std::atomic<uint32_t> removed;
+    };
+
+    struct ProcessSlot {
+        std::atomic<pid_t> pid;  // 0 when the slot is free
+        std::atomic<uint64_t> startTime; // Of the process in 'pid'; 0 while unknown
+        std::atomic<int> scans;  // Whole-list walks in progress; they block reclamation
+        std::atomic<uint64_t> accessed[MAX_THREADS][2]; // Hazard offsets per thread
+    };
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        std::atomic<uint32_t> ready; // Set once the object is initialized
+        uint64_t capacity;
+        pthread_mutex_t allocMutex;   // Protects the free list and 'top'
+        pthread_mutex_t reclaimMutex; // Protects the retire stack
+        std::atomic<uint64_t> top;    // End of the slots handed out so far
+        uint64_t freeList;
+        uint64_t head;                // Offset of the sentinel
+        uint64_t retired;             // Top of the retire stack
+        std::atomic<int64_t> length;
+        ProcessSlot processes[SHARED_MAX_PROCESSES];
+    };
+
+    class NodeLock {
+    public:
+        NodeLock() : node(nullptr) {}
+        NodeLock(SharedList* list, Node* node);
+        ~NodeLock();
+        void acquire(SharedList* list, Node* node);
+
+    private:
+        Node* node;
+    };
+
+    friend class SharedListCrash; // tests.cpp stops an update half way to check recovery
+
+    std::string name;
+    int fd;
+    char* base;
+    Header* header;
+    Node* head;
+    ProcessSlot* self;
+    std::atomic<int> operationCounter;
+
+    static uint64_t nodeArea();
+    Node* at(uint64_t offset) const;
+    uint64_t offsetOf(const Node* node) const;
+    Node* allocate(int val, uint64_t next);
+    void release(Node* node);
+    void retire(Node* node);
+    void repair(Node* node);
+    void initialize(size_t capacity);
+    bool claimSlot();
+    static void clearSlot(ProcessSlot& slot, pid_t pid);
+    bool validate(Node* pred, Node* curr);
+    void findWindow(int val, int threadID, Node*& pred, Node*& curr);
+    void resetAccessed(int threadID);
+    void countOperation();
+
+public:
+    SharedList();
+    ~SharedList(); // Leaves the list in place for the other processes
+
+    // Attach to the shared object 'name', creating it with 'capacity'
+    // bytes if it does not exist. Fails if another process keeps the
+    // object locked for SHARED_ATTACH_TIMEOUT_MS.
+    bool open(const std::string& name, size_t capacity = SHARED_DEFAULT_CAPACITY);
+    void close();
+    static bool destroy(const std::string& name); // Remove the object once every process is done
+
+    bool insert(int val, int threadID); // Insert 'val' in ascending order; false if the object is full
+    bool remove(int val, int threadID); // Remove 'val' if it exists
+    bool contains(int val, int threadID); // Check if 'val' is in the list
+
+    void scanAndReclaim(); // Free retired nodes no live process accesses
+
+    void printList(); // Print the list contents in ascending order
+    int get_length();
+    bool checkList();
+};
+
+#endif
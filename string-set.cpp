@@ -0,0 +1,146 @@
+#include "string-set.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+StringSet::Key::Key(std::string_view s)
+    : prefix(0), size(s.size()), tail(s.size() > STRING_PREFIX_BYTES ? s.data() + STRING_PREFIX_BYTES : nullptr) {
+    size_t n = std::min<size_t>(s.size(), STRING_PREFIX_BYTES);
+    for (size_t i = 0; i < n; ++i) {
+        prefix |= (uint64_t)(unsigned char)s[i] << (8 * (STRING_PREFIX_BYTES - 1 - i));
+    }
+}
+
+const char* StringSet::Node::tail() const {
+    return reinterpret_cast<const char*>(this + 1);
+}
+
+std::string StringSet::Node::key() const {
+    std::string out;
+    size_t n = std::min<size_t>(size, STRING_PREFIX_BYTES);
+    for (size_t i = 0; i < n; ++i) {
+        out.push_back((char)(prefix >> (8 * (STRING_PREFIX_BYTES - 1 - i))));
+    }
+    if (size > STRING_PREFIX_BYTES) {
+        out.append(tail(), size - STRING_PREFIX_BYTES);
+    }
+    return out;
+}
+
+// The node and its tail share one allocation
+StringSet::Node* StringSet::Node::create(const Key& key, Node* nxt) {
+    size_t tailSize = key.size > STRING_PREFIX_BYTES ? key.size - STRING_PREFIX_BYTES : 0;
+    void* block = ::operator new(sizeof(Node) + tailSize);
+    Node* node = new (block) Node();
+    node->prefix = key.prefix;
+    node->size = key.size;
+    node->next = nxt;
+    node->removed = false;
+    if (tailSize > 0) {
+        std::memcpy(reinterpret_cast<char*>(node + 1), key.tail, tailSize);
+    }
+    return node;
+}
+
+void StringSet::Node::release(Node* node) {
+    node->~Node();
+    ::operator delete(node);
+}
+
+StringSet::StringSet() : list(Node::create(Key(std::string_view()), nullptr), Node::release) {} // Sentinel
+
+// Zero padding makes a short key tie with a longer one that continues
+// with zero bytes, so equal prefixes of short keys fall back to the sizes
+int StringSet::Order::compare(uint64_t prefixA, size_t sizeA, const char* tailA, uint64_t prefixB, size_t sizeB,
+                              const char* tailB) {
+    if (prefixA != prefixB) {
+        return prefixA < prefixB ? -1 : 1;
+    }
+    if (sizeA > STRING_PREFIX_BYTES && sizeB > STRING_PREFIX_BYTES) {
+        int c = std::memcmp(tailA, tailB, std::min(sizeA, sizeB) - STRING_PREFIX_BYTES);
+        if (c != 0) {
+            return c;
+        }
+    }
+    if (sizeA != sizeB) {
+        return sizeA < sizeB ? -1 : 1;
+    }
+    return 0;
+}
+
+int StringSet::Order::operator()(const Node* node, const Key& key) const {
+    return compare(node->prefix, node->size, node->tail(), key.prefix, key.size, key.tail);
+}
+
+int StringSet::Order::operator()(const Node* a, const Node* b) const {
+    return compare(a->prefix, a->size, a->tail(), b->prefix, b->size, b->tail());
+}
+
+void StringSet::scanAndReclaim() {
+    list.scanAndReclaim();
+}
+
+bool StringSet::insert(std::string_view key, int threadID) {
+    Key k(key);
+    Node* pred;
+    Node* curr;
+    {
+        std::unique_lock<std::mutex> lockPred, lockCurr;
+        list.lockWindow(k, threadID, pred, curr, lockPred, lockCurr);
+        if (curr && Order()(curr, k) == 0) {
+            return false;
+        }
+        pred->next = Node::create(k, curr);
+    }
+    list.recordUpdate(1);
+    return true;
+}
+
+bool StringSet::remove(std::string_view key, int threadID) {
+    Key k(key);
+    Node* pred;
+    Node* curr;
+    {
+        std::unique_lock<std::mutex> lockPred, lockCurr;
+        list.lockWindow(k, threadID, pred, curr, lockPred, lockCurr);
+        if (!curr || Order()(curr, k) != 0) {
+            return false;
+        }
+        curr->removed = true;
+        pred->next = curr->next;
+        list.retireList.retire(curr);
+    }
+    list.recordUpdate(-1);
+    return true;
+}
+
+bool StringSet::contains(std::string_view key, int threadID) {
+    Key k(key);
+    Node* pred;
+    Node* curr;
+    list.findWindow(k, threadID, pred, curr);
+
+    bool found = (curr && !curr->removed && Order()(curr, k) == 0);
+    AccessedPointers::reset(threadID);
+    return found;
+}
+
+void StringSet::printList() {
+    Node* curr = list.head->next;
+    while (curr) {
+        if (!curr->removed) {
+            std::cout << curr->key() << " ";
+        }
+        curr = curr->next;
+    }
+    std::cout << std::endl;
+}
+
+int StringSet::get_length() {
+    return list.length;
+}
+
+bool StringSet::checkList() {
+    return list.checkList();
+}
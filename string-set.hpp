@@ -0,0 +1,73 @@
+#ifndef STRING_SET_H
+#define STRING_SET_H
+
+#include <iostream>
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+
+#include "lazy-list.hpp"
+
+#define STRING_PREFIX_BYTES 8
+
+// ------------------------------------------------------
+// Lazy List Set of Strings
+// ------------------------------------------------------
+// A LazyList whose nodes keep the first STRING_PREFIX_BYTES bytes of their
+// key inline as a big-endian integer, zero padded. Comparing two prefixes
+// as integers orders them like the bytes, so a traversal compares one
+// word per node. It reads the rest of a key only when the prefixes are
+// equal. The bytes past the prefix are allocated with the node, so a key
+// costs one allocation. Lookups take std::string_view and compute the
+// prefix of the key once per operation. Keys order like std::string.
+class StringSet {
+private:
+    struct Key {
+        uint64_t prefix;
+        size_t size;
+        const char* tail; // Bytes past the prefix, if the key is longer
+
+        explicit Key(std::string_view s);
+    };
+
+    struct Node {
+        uint64_t prefix;
+        size_t size;
+        Node* next;
+        mutable std::mutex m; // Protects this node
+        bool removed;         // 'true' if this node is logically removed
+
+        const char* tail() const; // Bytes past the prefix, stored after the node
+        std::string key() const; // The whole key, for printing
+        static Node* create(const Key& key, Node* nxt);
+        static void release(Node* node);
+    };
+
+    // Key order for LazyList: <0, 0 or >0 as the node's key is less, equal or greater
+    struct Order {
+        static int compare(uint64_t prefixA, size_t sizeA, const char* tailA, uint64_t prefixB, size_t sizeB,
+                           const char* tailB);
+        int operator()(const Node* node, const Key& key) const;
+        int operator()(const Node* a, const Node* b) const;
+    };
+
+    LazyList<Node, Key, Order> list;
+
+public:
+    StringSet();
+
+    bool insert(std::string_view key, int threadID); // false if 'key' is already present
+    bool remove(std::string_view key, int threadID); // Remove 'key' if it exists
+    bool contains(std::string_view key, int threadID);
+
+    void scanAndReclaim(); // Scan and Reclaim Memory
+
+    void printList(); // Print the keys in ascending order
+    int get_length();
+    bool checkList();
+};
+
+#endif
@@ -0,0 +1,1269 @@
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <random>
+#include <atomic>
+
+#include <climits>
+#include <cstdlib>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <dirent.h>
+#include <csignal>
+#include <string>
+#include <set>
+#include <chrono>
+#include <algorithm>
+
+#include "bounded-list.hpp"
+#include "range-list.hpp"
+#include "hybrid-set.hpp"
+#include "lsm-set.hpp"
+#include "blink-tree.hpp"
+#include "concurrent-linked-list.hpp"
+#include "persistent-list.hpp"
+#include "durable-list.hpp"
+#include "shared-list.hpp"
+#include "replicated-list.hpp"
+#include "change-feed.hpp"
+#include "thread-pool.hpp"
+#include "async-list.hpp"
+#include "marked-map.hpp"
+#include "string-set.hpp"
+#include "serialization.hpp"
+#include "list-protocol.hpp"
+
+// ------------------------------------------------------
+// Container Smoke Tests
+// ------------------------------------------------------
+// `make test` builds and runs these. Each check drives one container from
+// several threads, then verifies it with checkList and a few exact
+// expectations. The remaining checks cover recovery, replay and
+// ordering paths that main.cpp does not reach.
+
+#define TEST_THREADS 4
+
+static int failures = 0;
+
+static void expect(bool ok, const char* what) {
+    if (!ok) {
+        std::cout << "  FAIL: " << what << std::endl;
+        failures++;
+    }
+}
+
+// Run work(threadID) on TEST_THREADS threads; threadIDs start at 'firstID'
+template <typename F>
+static void runThreads(F work, int firstID = 0) {
+    std::vector<std::thread> threads;
+    for (int t = 0; t < TEST_THREADS; ++t) {
+        threads.emplace_back(work, firstID + t);
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+// An unlinked temporary file; the caller closes it
+static int tempFile() {
+    char path[] = "/tmp/cll-test-XXXXXX";
+    int fd = mkstemp(path);
+    if (fd >= 0) {
+        unlink(path);
+    }
+    return fd;
+}
+
+// A new empty directory for file-backed containers
+static std::string tempDir() {
+    char path[] = "/tmp/cll-test-XXXXXX";
+    return mkdtemp(path) ? path : "";
+}
+
+static void removeDir(const std::string& dir) {
+    DIR* d = opendir(dir.c_str());
+    if (!d) {
+        return;
+    }
+    while (dirent* entry = readdir(d)) {
+        std::string name = entry->d_name;
+        if (name != "." && name != "..") {
+            unlink((dir + "/" + name).c_str());
+        }
+    }
+    closedir(d);
+    rmdir(dir.c_str());
+}
+
+static void testBoundedList() {
+    std::cout << "BoundedList" << std::endl;
+    BoundedList list(100);
+    runThreads([&](int id) {
+        for (int key = id; key < 1000; key += TEST_THREADS) {
+            list.insert(key, id);
+        }
+    });
+    expect(list.checkList(), "bounded list is in eviction order");
+    expect(list.get_length() == 100, "bounded list is full");
+    expect(list.contains(999, 0) && list.contains(900, 0) && !list.contains(899, 0),
+           "bounded list keeps the largest keys");
+
+    runThreads([&](int id) {
+        for (int key = 900 + id; key < 950; key += TEST_THREADS) {
+            list.remove(key, id);
+        }
+    });
+    expect(list.checkList() && list.get_length() == 50, "bounded list removes");
+}
+
+static void testRangeList() {
+    std::cout << "RangeList" << std::endl;
+    RangeList list;
+    runThreads([&](int id) {
+        for (int key = id; key < 2000; key += TEST_THREADS) {
+            list.insert(key, id);
+        }
+        list.insertRange(5000 + id * 100, 5000 + id * 100 + 149, id); // Overlapping ranges
+    });
+    runThreads([&](int id) {
+        for (int key = id * 10; key < 2000; key += 100) {
+            list.remove(key, id);
+        }
+    });
+    expect(list.checkList(), "runs are disjoint and ordered");
+    expect(list.get_length() == 2000 - 80 + 450, "range list length");
+    expect(list.contains(5449, 0) && !list.contains(5450, 0) && !list.contains(110, 0), "range list contents");
+
+    RangeList wide;
+    wide.insertRange(INT_MIN, INT_MAX, 0);
+    expect(wide.get_length() == (1LL << 32), "a full-width range is counted without overflow");
+    wide.remove(0, 0);
+    expect(wide.get_length() == (1LL << 32) - 1 && wide.get_intervals() == 2, "splitting a full-width range");
+}
+
+// Each thread fills its own chunks so they pass through every container
+// kind, then empties most of them again while a reader searches them
+static void testHybridSet() {
+    std::cout << "HybridSet" << std::endl;
+    HybridSet set;
+    const int sizes[] = {10, 200, 6000};
+    std::atomic<bool> done(false);
+    std::thread reader([&] {
+        while (!done.load()) {
+            for (int k = 0; k < 3 * CHUNK_SIZE; k += 7) {
+                set.contains(k, TEST_THREADS);
+            }
+        }
+    });
+    runThreads([&](int id) {
+        for (int c = 0; c < 3; ++c) {
+            int base = (id * 3 + c) * CHUNK_SIZE;
+            for (int k = 0; k < sizes[c]; ++k) {
+                set.insert(base + k * 7, id);
+            }
+            for (int k = 5; k < sizes[c]; ++k) {
+                set.remove(base + k * 7, id);
+            }
+        }
+    });
+    done.store(true);
+    reader.join();
+    expect(set.checkList(), "chunks are sorted and use the right container");
+    expect(set.get_length() == TEST_THREADS * 3 * 5, "hybrid set length");
+    expect(set.contains(CHUNK_SIZE * 2 + 28, 0) && !set.contains(CHUNK_SIZE * 2 + 35, 0), "hybrid set contents");
+}
+
+static void testLsmSet() {
+    std::cout << "LsmSet" << std::endl;
+    LsmSet set;
+    // Enough keys for several flushes and merges while the threads run
+    runThreads([&](int id) {
+        for (int key = id; key < 20000; key += TEST_THREADS) {
+            set.insert(key, id);
+        }
+        for (int key = id; key < 20000; key += 2 * TEST_THREADS) {
+            set.remove(key, id);
+        }
+    });
+    expect(set.checkList(), "lsm set is sorted");
+    expect(set.get_length() == 10000, "lsm set counts each live key once");
+    expect(set.contains(4, 0) && !set.contains(0, 0) && !set.contains(3, 0),
+           "lsm set tombstones hide older runs");
+
+    set.flush();
+    set.insert(0, 0);
+    set.remove(4, 0);
+    expect(set.get_length() == 10000, "memtable entries override runs");
+    expect(set.contains(0, 0) && !set.contains(4, 0), "lsm set newest layer wins");
+
+    // Fill the memtable so a background flush starts, then write once more;
+    // flush() must not settle for the iteration already in flight
+    bool drained = true;
+    for (int round = 0; round < 50; ++round) {
+        int base = 100000 + round * (MEMTABLE_LIMIT + 1);
+        for (int key = base; key < base + MEMTABLE_LIMIT; ++key) {
+            set.insert(key, 0);
+        }
+        set.insert(base + MEMTABLE_LIMIT, 0);
+        set.flush();
+        drained = drained && set.get_buffered() == 0;
+    }
+    expect(drained, "flush waits for writes made during a running flush");
+}
+
+static void testBLinkTree() {
+    std::cout << "BLinkTree" << std::endl;
+    BLinkTree tree;
+    runThreads([&](int id) {
+        for (int key = id; key < 50000; key += TEST_THREADS) {
+            tree.insert(key, id);
+        }
+    });
+    expect(tree.checkList() && tree.get_length() == 50000, "tree holds every key");
+    expect(tree.get_height() > 1, "tree has split");
+
+    // Empty most leaves so they merge while a reader scans and looks up keys
+    // that stay (multiples of 100)
+    std::atomic<bool> done(false);
+    std::atomic<int> misses(0);
+    std::thread reader([&]() {
+        while (!done.load()) {
+            for (int key = 0; key < 50000; key += 100) {
+                misses += !tree.contains(key, TEST_THREADS);
+            }
+            std::vector<int> out;
+            tree.rangeScan(0, 49999, out, TEST_THREADS);
+            for (size_t i = 1; i < out.size(); ++i) {
+                misses += out[i] <= out[i - 1];
+            }
+        }
+    });
+    runThreads([&](int id) {
+        for (int key = id; key < 50000; key += TEST_THREADS) {
+            if (key % 100 != 0) {
+                tree.remove(key, id);
+            }
+        }
+    });
+    done = true;
+    reader.join();
+
+    expect(misses == 0, "readers see kept keys in order while leaves merge");
+    expect(tree.checkList() && tree.get_length() == 500, "tree holds the kept keys");
+    std::vector<int> out;
+    expect(tree.rangeScan(0, 49999, out, 0) == 500 && out.front() == 0 && out.back() == 49900,
+           "range scan after merges");
+}
+
+static void testSnapshot() {
+    std::cout << "MarkedList snapshot" << std::endl;
+    MarkedList list;
+    runThreads([&](int id) {
+        for (int key = id; key < 4000; key += TEST_THREADS) {
+            list.insert(key * 3 - 6000, id);
+        }
+        for (int key = id; key < 4000; key += 2 * TEST_THREADS) {
+            list.remove(key * 3 - 6000, id);
+            list.contains(key * 3 - 6000, id);
+        }
+    });
+    expect(list.checkList() && list.get_length() == 2000, "list after inserts and removes");
+
+    int fd = tempFile();
+    expect(fd >= 0 && list.save(fd), "save snapshot");
+    MarkedList loaded;
+    expect(lseek(fd, 0, SEEK_SET) == 0 && loaded.load(fd), "load snapshot");
+    expect(loaded.checkList() && loaded.keys() == list.keys(), "snapshot round trip");
+
+    // Flip one byte in the middle: the checksum must reject the file
+    char byte;
+    off_t middle = lseek(fd, 0, SEEK_END) / 2;
+    expect(pread(fd, &byte, 1, middle) == 1, "read snapshot byte");
+    byte ^= 0x40;
+    expect(pwrite(fd, &byte, 1, middle) == 1, "corrupt snapshot byte");
+    MarkedList corrupt;
+    expect(lseek(fd, 0, SEEK_SET) == 0 && !corrupt.load(fd) && corrupt.get_length() == 0,
+           "corrupt snapshot is rejected");
+    close(fd);
+
+    MarkedList bulk;
+    expect(!bulk.bulkLoad({3, 1, 2}), "bulk load rejects unsorted keys");
+    expect(bulk.bulkLoad({1, 2, 3}) && bulk.checkList() && bulk.get_length() == 3, "bulk load");
+}
+
+static void testPersistentList() {
+    std::cout << "PersistentList" << std::endl;
+    char path[] = "/tmp/cll-test-XXXXXX";
+    int fd = mkstemp(path);
+    expect(fd >= 0, "create persistent file");
+    close(fd);
+    unlink(path); // open() creates it with the right size
+
+    // The child fills the list and dies without close(), as in a crash
+    int ready[2];
+    int quit[2];
+    expect(pipe(ready) == 0 && pipe(quit) == 0, "pipes");
+    pid_t child = fork();
+    if (child == 0) {
+        PersistentList list;
+        if (!list.open(path, 1 << 20)) {
+            _exit(1);
+        }
+        runThreads([&](int id) {
+            for (int key = id; key < 2000; key += TEST_THREADS) {
+                list.insert(key, id);
+                list.contains(key, id);
+            }
+            for (int key = id; key < 2000; key += 2 * TEST_THREADS) {
+                list.remove(key, id);
+            }
+        });
+        char c = 0;
+        if (write(ready[1], &c, 1) != 1 || read(quit[0], &c, 1) != 1) {
+            _exit(1);
+        }
+        _exit(list.checkList() ? 0 : 1);
+    }
+
+    char c = 0;
+    expect(read(ready[0], &c, 1) == 1, "child filled the list");
+    PersistentList busy;
+    expect(!busy.open(path, 1 << 20), "open fails while another process holds the file");
+    expect(write(quit[1], &c, 1) == 1, "stop child");
+    int status = 0;
+    waitpid(child, &status, 0);
+    expect(WIFEXITED(status) && WEXITSTATUS(status) == 0, "child list was consistent");
+    for (int p : {ready[0], ready[1], quit[0], quit[1]}) {
+        close(p);
+    }
+
+    {
+        PersistentList list;
+        expect(list.open(path, 1 << 20) && list.recovered(), "reopen after a crash recovers");
+        expect(list.checkList() && list.get_length() == 1000, "recovered list keeps its keys");
+        expect(list.contains(4, 0) && !list.contains(3, 0), "recovered keys");
+        runThreads([&](int id) {
+            for (int key = id; key < 2000; key += TEST_THREADS) {
+                list.remove(key, id);
+            }
+        });
+        expect(list.checkList() && list.get_length() == 0, "recovered list accepts updates");
+        list.insert(42, 0);
+    }
+    {
+        PersistentList list;
+        expect(list.open(path, 1 << 20) && !list.recovered(), "clean close needs no recovery");
+        expect(list.get_length() == 1 && list.contains(42, 0), "clean reopen keeps keys");
+    }
+    unlink(path);
+}
+
+static void testDurableList() {
+    std::cout << "DurableList" << std::endl;
+    std::vector<WriteAheadLog::Record> records = {
+        {2, 5, WriteAheadLog::Op::Remove}, {1, 5, WriteAheadLog::Op::Insert},
+        {3, 7, WriteAheadLog::Op::Insert}, {4, 1, WriteAheadLog::Op::Remove}};
+    expect(WriteAheadLog::replay(records, 2, {1, 3}) == std::vector<int>({3, 7}),
+           "replay applies records in LSN order per key");
+
+    std::string dir = tempDir();
+    std::string path = dir + "/list";
+    std::vector<int> expected;
+    {
+        DurableList list;
+        expect(list.open(path), "open new durable list");
+        runThreads([&](int id) {
+            for (int key = id; key < 4000; key += TEST_THREADS) {
+                list.insert(key, id);
+            }
+        });
+        expect(list.checkpoint(), "start checkpoint");
+        runThreads([&](int id) {
+            auto mode = id % 2 ? DurableList::Durability::Durable : DurableList::Durability::Async;
+            for (int key = id; key < 4000; key += 2 * TEST_THREADS) {
+                expect(list.remove(key, id, mode), "durable remove");
+                list.contains(key, id);
+            }
+            for (int key = 4000 + id; key < 5000; key += TEST_THREADS) {
+                expect(list.insert(key, id, mode), "durable insert");
+            }
+        });
+        expect(list.waitCheckpoint(), "checkpoint written");
+        expect(list.sync(), "sync");
+        expect(list.get_list().checkList() && list.get_list().get_length() == 3000, "durable list length");
+        expected = list.get_list().keys();
+        list.close();
+    }
+    {
+        DurableList list;
+        expect(list.open(path, 3), "reopen durable list");
+        expect(list.get_list().checkList() && list.get_list().keys() == expected,
+               "checkpoint plus log replay restores the keys");
+
+        // The next checkpoint starts from the previous one and the log
+        runThreads([&](int id) {
+            for (int key = 1 + 2 * id; key < 1000; key += 2 * TEST_THREADS) {
+                list.remove(key, id);
+                list.insert(-key, id);
+            }
+        });
+        expect(list.checkpoint() && list.waitCheckpoint(), "second checkpoint");
+        list.insert(5000, 0);
+        expected = list.get_list().keys();
+        list.close();
+    }
+    {
+        DurableList list;
+        expect(list.open(path) && list.get_list().keys() == expected,
+               "second checkpoint plus log replay restores the keys");
+        list.close();
+    }
+
+    // A child whose files may not grow sees its durable updates fail
+    pid_t child = fork();
+    if (child == 0) {
+        DurableList list;
+        if (!list.open(path)) {
+            _exit(1);
+        }
+        signal(SIGXFSZ, SIG_IGN);
+        rlimit limit = {4096, 4096};
+        setrlimit(RLIMIT_FSIZE, &limit);
+        bool failed = false;
+        for (int key = 10000; key < 20000 && !failed; ++key) {
+            failed = !list.insert(key, 0, DurableList::Durability::Durable);
+        }
+        _exit(failed && !list.sync() ? 0 : 1);
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    expect(WIFEXITED(status) && WEXITSTATUS(status) == 0, "durable updates fail once the log fails");
+    removeDir(dir);
+}
+
+// Stops a remove after it marks the node and before it unlinks it, with
+// both node locks held, as a crash there would
+class SharedListCrash {
+public:
+    static void markAndDie(SharedList& list, int val) {
+        SharedList::Node* pred;
+        SharedList::Node* curr;
+        list.findWindow(val, 0, pred, curr);
+        pthread_mutex_lock(&pred->m);
+        pthread_mutex_lock(&curr->m);
+        curr->removed.store(1);
+        _exit(0);
+    }
+};
+
+static void testSharedList() {
+    std::cout << "SharedList" << std::endl;
+    std::string name = "/cll-test-" + std::to_string(getpid());
+    SharedList::destroy(name);
+    SharedList list;
+    expect(list.open(name, 1 << 20), "create shared list");
+    runThreads([&](int id) {
+        for (int key = id; key < 2000; key += TEST_THREADS) {
+            list.insert(key, id);
+            list.contains(key, id);
+        }
+        for (int key = id; key < 2000; key += 2 * TEST_THREADS) {
+            list.remove(key, id);
+        }
+    });
+    expect(list.checkList() && list.get_length() == 1000, "shared list after concurrent updates");
+
+    // A process that dies attached leaves its slot, which the next scan clears
+    pid_t child = fork();
+    if (child == 0) {
+        SharedList other;
+        if (!other.open(name) || !other.insert(5000, 0) || !other.contains(4, 0)) {
+            _exit(1);
+        }
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    expect(WIFEXITED(status) && WEXITSTATUS(status) == 0, "second process shares the list");
+    list.scanAndReclaim();
+    expect(list.contains(5000, 0) && list.checkList(), "shared list after a process died attached");
+
+    // A process that dies between marking a node and unlinking it leaves
+    // the node linked; searches past it must repair it rather than spin
+    child = fork();
+    if (child == 0) {
+        SharedList other;
+        if (other.open(name)) {
+            SharedListCrash::markAndDie(other, 4);
+        }
+        _exit(1);
+    }
+    waitpid(child, &status, 0);
+    child = fork();
+    if (child == 0) {
+        alarm(10);
+        SharedList other;
+        bool ok = other.open(name) && other.contains(1500, 0) && other.insert(1501, 0) && !other.contains(4, 0);
+        _exit(ok ? 0 : 1);
+    }
+    waitpid(child, &status, 0);
+    expect(WIFEXITED(status) && WEXITSTATUS(status) == 0, "searches past a half-removed node finish");
+    expect(list.checkList() && list.contains(1501, 0), "half-removed node is unlinked");
+    list.close();
+    SharedList::destroy(name);
+
+    // A creator that died before initializing leaves an object that is not ready
+    for (off_t size : {(off_t)0, (off_t)(1 << 20)}) {
+        int fd = shm_open(name.c_str(), O_RDWR | O_CREAT, 0600);
+        expect(fd >= 0 && ftruncate(fd, size) == 0, "leave an uninitialized object");
+        close(fd);
+        SharedList again;
+        expect(again.open(name, 1 << 20), "open re-initializes an object that is not ready");
+        expect(again.insert(1, 0) && again.contains(1, 0) && again.get_length() == 1,
+               "re-initialized list works");
+        again.close();
+        SharedList::destroy(name);
+    }
+}
+
+static void testReplicatedList() {
+    std::cout << "ReplicatedList" << std::endl;
+    // Two replicas even on one node; more updates than log entries, so
+    // writers also bring the idle replica up to date
+    ReplicatedList list(2);
+    std::atomic<int> removed(0);
+    runThreads([&](int id) {
+        for (int key = id; key < 3 * REPLICATED_LOG_SIZE; key += TEST_THREADS) {
+            list.insert(key, id);
+            expect(list.contains(key, id), "replicated insert is visible to its thread");
+        }
+        for (int key = id; key < 3 * REPLICATED_LOG_SIZE; key += 2 * TEST_THREADS) {
+            removed += list.remove(key, id);
+        }
+    });
+    expect(removed == 3 * REPLICATED_LOG_SIZE / 2, "every remove found its key");
+    expect(list.checkList(0) && list.get_length() == 3 * REPLICATED_LOG_SIZE / 2, "local replica is current");
+}
+
+static void testChangeFeed() {
+    std::cout << "ChangeFeed" << std::endl;
+    MarkedList list;
+    ChangeFeed feed;
+    list.setChangeFeed(&feed);
+    ChangeFeed::Subscriber sub = feed.subscribe();
+
+    // Replaying the feed from the start, or from a snapshot taken while
+    // updates run, must reproduce the list
+    uint64_t seq = 0;
+    std::vector<int> snapped;
+    std::thread snapper([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        snapped = list.snapshot(seq);
+    });
+    runThreads([&](int id) {
+        for (int key = id; key < 4000; key += TEST_THREADS) {
+            list.insert(key, id);
+        }
+        for (int key = id; key < 4000; key += 2 * TEST_THREADS) {
+            list.remove(key, id);
+        }
+    });
+    snapper.join();
+
+    std::vector<ChangeFeed::Change> changes;
+    expect(sub.poll(changes, CHANGE_FEED_CAPACITY), "subscriber keeps up");
+    expect(changes.size() == 6000 && feed.head() == 6000, "one change per update");
+    std::multiset<int> replayed;
+    std::multiset<int> fromSnapshot(snapped.begin(), snapped.end());
+    for (const ChangeFeed::Change& change : changes) {
+        for (std::multiset<int>* keys : {&replayed, &fromSnapshot}) {
+            if (keys == &fromSnapshot && change.seq < seq) {
+                continue;
+            }
+            if (change.op == ChangeFeed::Op::Insert) {
+                keys->insert(change.key);
+            } else if (keys->count(change.key) == 0) {
+                expect(false, "a remove follows its insert");
+            } else {
+                keys->erase(keys->find(change.key));
+            }
+        }
+    }
+    std::vector<int> live = list.keys();
+    expect(std::vector<int>(replayed.begin(), replayed.end()) == live, "replay reproduces the list");
+    expect(std::vector<int>(fromSnapshot.begin(), fromSnapshot.end()) == live,
+           "snapshot plus later changes reproduces the list");
+
+    // A subscriber more than a ring behind is told to resync
+    MarkedList small;
+    ChangeFeed ring(16);
+    small.setChangeFeed(&ring);
+    ChangeFeed::Subscriber late = ring.subscribe();
+    for (int key = 0; key < 100; ++key) {
+        small.insert(key, 0);
+    }
+    changes.clear();
+    expect(!late.poll(changes, 100), "overwritten changes need a resync");
+}
+
+static void testParallelBuild() {
+    std::cout << "MarkedList parallelBuild" << std::endl;
+    std::mt19937 rng(89);
+    std::vector<int> keys;
+    for (int i = 0; i < 10000; ++i) {
+        keys.push_back((int)(rng() % 5000)); // Duplicates included
+    }
+    MarkedList list;
+    expect(list.parallelBuild(keys, TEST_THREADS), "parallelBuild into an empty list");
+    std::sort(keys.begin(), keys.end());
+    expect(list.keys() == keys && list.checkList(), "parallelBuild links the sorted keys");
+    expect(!list.parallelBuild(keys, TEST_THREADS), "parallelBuild refuses a non-empty list");
+
+    // The built nodes take ordinary updates afterwards
+    runThreads([&](int id) {
+        for (int key = id; key < 5000; key += TEST_THREADS) {
+            list.insert(key, id);
+            list.remove(key, id);
+        }
+    });
+    expect(list.keys() == keys && list.checkList(), "updates on built nodes");
+}
+
+static void testParallelReduce() {
+    std::cout << "MarkedList parallelReduce" << std::endl;
+    std::vector<int> keys;
+    for (int key = 0; key < 20000; ++key) {
+        keys.push_back(key);
+    }
+    MarkedList list;
+    list.parallelBuild(keys, TEST_THREADS); // Seeds the split nodes
+    ThreadPool pool(TEST_THREADS);
+
+    // Scans run while their split nodes are being removed
+    std::atomic<bool> done(false);
+    std::thread scanner([&] {
+        while (!done) {
+            expect(list.parallelCheckList(pool), "parallelCheckList during updates");
+        }
+    });
+    runThreads([&](int id) {
+        for (int key = id; key < 20000; key += 2 * TEST_THREADS) {
+            list.remove(key, id);
+        }
+    });
+    done = true;
+    scanner.join();
+
+    std::vector<int> live = list.keys();
+    long long sum = 0;
+    for (int key : live) {
+        sum += key;
+    }
+    int min = 0, max = 0;
+    expect(list.parallelCount(pool) == (long long)live.size() && list.parallelSum(pool) == sum,
+           "parallel count and sum match keys()");
+    expect(list.parallelMinMax(pool, min, max) && min == live.front() && max == live.back(),
+           "parallelMinMax matches keys()");
+    MarkedList empty;
+    expect(!empty.parallelMinMax(pool, min, max) && empty.parallelCount(pool) == 0, "empty list reduces to nothing");
+}
+
+static void testSetAlgebra() {
+    std::cout << "MarkedList merge" << std::endl;
+    MarkedList a, b;
+    a.bulkLoad({1, 2, 2, 2, 5, 7});
+    b.bulkLoad({2, 2, 3, 5, 5, 9});
+    auto run = [&](MarkedList::SetOp op) {
+        std::vector<int> out;
+        a.merge(b, op, [&](int key) { out.push_back(key); });
+        return out;
+    };
+    expect(run(MarkedList::SetOp::Union) == std::vector<int>({1, 2, 2, 2, 3, 5, 5, 7, 9}), "multiset union");
+    expect(run(MarkedList::SetOp::Intersection) == std::vector<int>({2, 2, 5}), "multiset intersection");
+    expect(run(MarkedList::SetOp::Difference) == std::vector<int>({1, 2, 7}), "multiset difference");
+
+    MarkedList result;
+    expect(a.mergeInto(b, MarkedList::SetOp::Intersection, result) && result.checkList() &&
+           result.keys() == std::vector<int>({2, 2, 5}), "mergeInto bulk loads the result");
+    expect(!a.mergeInto(b, MarkedList::SetOp::Union, result), "mergeInto refuses a non-empty result");
+
+    // mergeFrom while other threads update disjoint keys of the same list
+    MarkedList target, source;
+    std::vector<int> sourceKeys;
+    for (int key = 0; key < 4000; key += 3) {
+        sourceKeys.push_back(key);
+    }
+    source.bulkLoad(sourceKeys);
+    runThreads([&](int id) {
+        if (id == 0) {
+            target.mergeFrom(source, id);
+            return;
+        }
+        for (int key = 4000 + id; key < 8000; key += TEST_THREADS) {
+            target.insert(key, id);
+        }
+    });
+    std::vector<int> expected = sourceKeys;
+    for (int key = 4000; key < 8000; ++key) {
+        if (key % TEST_THREADS != 0) {
+            expected.push_back(key);
+        }
+    }
+    expect(target.keys() == expected && target.checkList(), "mergeFrom alongside inserts");
+    target.mergeFrom(source, 0);
+    expect(target.keys() == expected, "mergeFrom inserts only missing keys");
+}
+
+static void testSplitSplice() {
+    std::cout << "MarkedList split/splice" << std::endl;
+    std::vector<int> keys;
+    for (int key = 0; key < 2000; ++key) {
+        keys.push_back(key);
+    }
+    MarkedList left, right;
+    ChangeFeed leftFeed, rightFeed;
+    left.setChangeFeed(&leftFeed);
+    right.setChangeFeed(&rightFeed);
+    left.bulkLoad(keys); // Bulk loads are not published
+
+    // Replaying each feed over a snapshot must match its list after the move
+    uint64_t leftSeq = 0, rightSeq = 0;
+    std::vector<int> leftBase = left.snapshot(leftSeq);
+    std::vector<int> rightBase = right.snapshot(rightSeq);
+    auto replay = [](ChangeFeed& feed, uint64_t from, std::vector<int> base) {
+        ChangeFeed::Subscriber sub = feed.subscribe();
+        sub.seek(from);
+        std::vector<ChangeFeed::Change> changes;
+        expect(sub.poll(changes, CHANGE_FEED_CAPACITY), "feed holds every move");
+        std::multiset<int> keys(base.begin(), base.end());
+        for (const ChangeFeed::Change& change : changes) {
+            if (change.op == ChangeFeed::Op::Insert) {
+                keys.insert(change.key);
+            } else if (keys.count(change.key) == 0) {
+                expect(false, "a moved key is removed after its insert");
+            } else {
+                keys.erase(keys.find(change.key));
+            }
+        }
+        return std::vector<int>(keys.begin(), keys.end());
+    };
+
+    // Split and splice back and forth while other threads update both lists;
+    // each round publishes two records per moved key
+    runThreads([&](int id) {
+        if (id == 0) {
+            for (int round = 0; round < 10; ++round) {
+                expect(left.split(1000, right, id), "split into the empty list");
+                expect(left.splice(right, id), "splice the keys back");
+            }
+            return;
+        }
+        for (int key = id; key < 2000; key += TEST_THREADS) {
+            MarkedList& list = (key < 1000) ? left : right;
+            list.remove(key, id);
+        }
+    });
+    expect(left.checkList() && right.checkList(), "lists after split/splice");
+    expect(replay(leftFeed, leftSeq, leftBase) == left.keys() && replay(rightFeed, rightSeq, rightBase) == right.keys(),
+           "feeds follow the moved keys");
+
+    // Cursors open on both lists hold off neither split nor splice, from
+    // their own thread or another, and start again from head afterwards
+    MarkedList::Cursor leftCursor(left, 0);
+    MarkedList::Cursor rightCursor(right, 1);
+    expect(leftCursor.seek(600), "cursor on a key to be moved");
+    runThreads([&](int id) {
+        if (id == 2) {
+            expect(left.split(500, right, id) && right.splice(left, id) == false, "split beside open cursors");
+        }
+    });
+    expect(right.contains(leftCursor.key(), 0) && !left.contains(leftCursor.key(), 0), "cursor key moved");
+    expect(!leftCursor.seek(600), "cursor restarts in its own list, not the moved chain");
+    expect(right.splice(left, 0) == false && left.splice(right, 0), "splice from the cursor's thread");
+    expect(leftCursor.seek(600) && leftCursor.key() >= 600 && left.checkList(), "cursor after splice");
+}
+
+static void testRemoveIf() {
+    std::cout << "MarkedList removeIf" << std::endl;
+    MarkedList list;
+    runThreads([&](int id) {
+        for (int key = id; key < 4000; key += TEST_THREADS) {
+            list.insert(key, id);
+        }
+    });
+    // Thread 0 sweeps while the others insert keys above 4000 that never match
+    std::atomic<int> removed(0);
+    runThreads([&](int id) {
+        if (id == 0) {
+            removed += list.removeIf([](int key) { return key % 3 == 0; }, id);
+            removed += list.removeIf(1000, 1999, [](int key) { return key % 3 != 0; }, id);
+            return;
+        }
+        for (int key = 4000 + 3 * id; key < 6000; key += 3 * TEST_THREADS) {
+            list.insert(key, id);
+        }
+    });
+    bool exact = true;
+    for (int key = 0; key < 4000; ++key) {
+        bool kept = key % 3 != 0 && (key < 1000 || key > 1999);
+        exact = exact && list.contains(key, 0) == kept;
+    }
+    expect(exact && list.checkList(), "removeIf removes exactly the matching keys");
+    expect(removed == 1334 + 667, "removeIf counts its removals");
+}
+
+static void testApplyBatch() {
+    std::cout << "MarkedList applyBatch" << std::endl;
+    MarkedList list;
+    std::multiset<int> model;
+    for (int key = 0; key < 1000; key += 2) {
+        list.insert(key, 0);
+        model.insert(key);
+    }
+    // Results must match applying the ops one by one in their original order
+    std::mt19937 rng(94);
+    std::vector<MarkedList::BatchOp> ops;
+    std::vector<uint8_t> expected;
+    for (int i = 0; i < 20000; ++i) {
+        MarkedList::BatchOp op;
+        op.type = (MarkedList::BatchOp::Type)(rng() % 3);
+        op.key = (int)(rng() % 1000);
+        ops.push_back(op);
+        if (op.type == MarkedList::BatchOp::Type::Insert) {
+            model.insert(op.key);
+            expected.push_back(1);
+        } else if (model.count(op.key) == 0) {
+            expected.push_back(0);
+        } else {
+            if (op.type == MarkedList::BatchOp::Type::Remove) {
+                model.erase(model.find(op.key));
+            }
+            expected.push_back(1);
+        }
+    }
+    ThreadPool pool(TEST_THREADS);
+    std::vector<uint8_t> results;
+    expect(list.applyBatch(ops, results, pool, 0) && results == expected, "batch results in original order");
+    expect(list.keys() == std::vector<int>(model.begin(), model.end()) && list.checkList(), "batch applied");
+    expect(!list.applyBatch(ops, results, pool, MAX_THREADS - 1), "thread range past MAX_THREADS is refused");
+}
+
+static void testAsyncList() {
+    std::cout << "AsyncList" << std::endl;
+    MarkedList list;
+    std::atomic<int> live(0);
+    {
+        AsyncList async(list, 0); // Producers use threadIDs 1 .. TEST_THREADS
+        runThreads([&](int id) {
+            std::vector<AsyncList::Future> inserts, removes, missing;
+            for (int key = id; key < 4000; key += TEST_THREADS) {
+                inserts.push_back(async.insertAsync(key, id));
+            }
+            for (int key = id; key < 4000; key += 2 * TEST_THREADS) {
+                removes.push_back(async.removeAsync(key, id));
+                missing.push_back(async.removeAsync(key, id)); // Applied after the first remove
+            }
+            bool ok = true;
+            for (AsyncList::Future& f : inserts) {
+                ok = ok && f.get();
+            }
+            for (size_t i = 0; i < removes.size(); ++i) {
+                ok = ok && removes[i].get() && !missing[i].get() && missing[i].ready();
+            }
+            expect(ok, "async results follow each thread's order");
+            async.flush(id);
+            expect(async.contains(id + TEST_THREADS, id) && !async.contains(id, id),
+                   "flush makes the thread's updates visible");
+            live += (int)(inserts.size() - removes.size());
+        }, 1);
+    }
+    expect(list.get_length() == live && list.checkList(), "destructor applies every update");
+
+    // A thread more than a result ring ahead of the applier waits for it
+    MarkedList ahead;
+    {
+        AsyncList async(ahead, 0);
+        AsyncList::Future last;
+        for (int key = 0; key < 3 * ASYNC_RESULT_RING; ++key) {
+            last = async.insertAsync(key, 1);
+        }
+        expect(last.get() && ahead.get_length() == 3 * ASYNC_RESULT_RING, "result ring does not wrap over unread results");
+    }
+
+    // An applier range outside the list's threadIDs aborts at construction
+    pid_t child = fork();
+    if (child == 0) {
+        int null = open("/dev/null", O_WRONLY);
+        dup2(null, STDERR_FILENO);
+        AsyncList bad(list, MAX_THREADS - 1, 2);
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    expect(WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT, "bad applier threadIDs abort");
+}
+
+static void testCursor() {
+    std::cout << "MarkedList Cursor" << std::endl;
+    MarkedList list;
+    runThreads([&](int id) {
+        MarkedList::Cursor cursor(list, id);
+        for (int key = id; key < 4000; key += TEST_THREADS) {
+            cursor.insert(key);
+        }
+        // Walk forward from this thread's first key, removing its keys with
+        // key mod 8 < 4 as it passes them; other threads' keys may move
+        bool ordered = cursor.seek(id) && cursor.key() == id;
+        int last = -1;
+        while (cursor.valid()) {
+            int key = cursor.key();
+            ordered = ordered && key > last;
+            last = key;
+            if (key % TEST_THREADS == id && key % (2 * TEST_THREADS) < TEST_THREADS) {
+                ordered = ordered && cursor.remove();
+            } else {
+                cursor.next();
+            }
+        }
+        expect(ordered, "cursor walks ascending keys and removes its own");
+    });
+    bool exact = true;
+    for (int key = 0; key < 4000; ++key) {
+        exact = exact && list.contains(key, 0) == (key % (2 * TEST_THREADS) >= TEST_THREADS);
+    }
+    expect(exact && list.get_length() == 2000 && list.checkList(), "cursor updates applied");
+
+    MarkedList::Cursor cursor(list, 0);
+    expect(cursor.seek(3999) && cursor.key() == 3999 && !cursor.next() && !cursor.valid(), "cursor stops at the end");
+
+    // Containers that publish in ENCLOSING_PTR_INDEX, used by the same
+    // thread, must leave the cursor's node protected while another thread
+    // removes and reclaims it
+    HybridSet hybrid;
+    LsmSet lsm;
+    expect(cursor.seek(3004) && cursor.key() == 3004, "cursor after its predecessor");
+    hybrid.insert(3004, 0);
+    expect(hybrid.contains(3004, 0) && !lsm.contains(3004, 0), "other containers on the cursor's thread");
+    expect(list.remove(2999, 1), "remove the cursor's predecessor");
+    list.scanAndReclaim();
+    expect(cursor.next() && cursor.key() == 3005, "cursor survives its predecessor's removal");
+}
+
+static void testWaitFor() {
+    std::cout << "MarkedList waitFor" << std::endl;
+    MarkedList list;
+    // Threads 1 .. 3 wait for keys that thread 0 inserts later; a bulk load
+    // into a second list must wake its waiters too
+    MarkedList loaded;
+    runThreads([&](int id) {
+        if (id == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            for (int key = 0; key < 100; ++key) {
+                list.insert(key, id);
+            }
+            loaded.bulkLoad({7});
+            return;
+        }
+        bool ok = true;
+        for (int key = id; key < 100; key += TEST_THREADS) {
+            ok = ok && list.waitFor(key, std::chrono::seconds(10), id);
+        }
+        expect(ok && loaded.waitFor(7, std::chrono::seconds(10), id), "waiters wake on insert and bulk load");
+    });
+    auto start = std::chrono::steady_clock::now();
+    expect(!list.waitFor(1000, std::chrono::milliseconds(20), 0), "waitFor times out");
+    expect(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(20), "timeout is honoured");
+    expect(list.waitFor(50, std::chrono::milliseconds(0), 0), "present key returns at once");
+}
+
+static void testMove() {
+    std::cout << "MarkedList move" << std::endl;
+    MarkedList a, b;
+    std::vector<int> keys;
+    for (int key = 0; key < 1000; ++key) {
+        keys.push_back(key);
+    }
+    a.bulkLoad(keys);
+    // Every thread moves all keys across and back in opposite directions
+    runThreads([&](int id) {
+        MarkedList& from = (id % 2 == 0) ? a : b;
+        MarkedList& to = (id % 2 == 0) ? b : a;
+        for (int round = 0; round < 5; ++round) {
+            for (int key = 0; key < 1000; ++key) {
+                MarkedList::move(key, from, to, id);
+                MarkedList::move(key, to, from, id);
+            }
+        }
+    });
+    bool once = true;
+    for (int key = 0; key < 1000; ++key) {
+        once = once && (a.contains(key, 0) != b.contains(key, 0));
+    }
+    expect(once && a.get_length() + b.get_length() == 1000 && a.checkList() && b.checkList(),
+           "each key ends up in exactly one list");
+    expect(!MarkedList::move(5000, a, b, 0), "moving a missing key fails");
+}
+
+static void testMarkedMap() {
+    std::cout << "MarkedMap" << std::endl;
+    MarkedMap map;
+    runThreads([&](int id) {
+        for (int key = id; key < 4000; key += TEST_THREADS) {
+            expect(map.insert(key, key, id), "insert a new key");
+        }
+        for (int key = id; key < 4000; key += 2 * TEST_THREADS) {
+            expect(map.remove(key, id), "remove a present key");
+        }
+        // Every thread adds to shared counters under upsert and compareAndSet
+        for (int i = 0; i < 1000; ++i) {
+            map.upsert(-1, 1, [](long long old, long long add) { return old + add; }, id);
+            long long seen = 0;
+            map.computeIfAbsent(-2, [](int) { return 0LL; }, id);
+            while (!map.compareAndSet(-2, seen, seen + 1, id, &seen)) {
+            }
+        }
+    });
+    long long a = 0, b = 0;
+    expect(map.get(-1, a, 0) && a == 1000 * TEST_THREADS && map.get(-2, b, 0) && b == 1000 * TEST_THREADS,
+           "upsert and compareAndSet do not lose updates");
+    bool exact = true;
+    for (int key = 0; key < 4000; ++key) {
+        long long value = -1;
+        bool present = map.get(key, value, 0);
+        exact = exact && present == (key % (2 * TEST_THREADS) >= TEST_THREADS) && (!present || value == key);
+    }
+    expect(exact && map.get_length() == 2002 && map.checkList(), "map holds the remaining keys");
+    long long old = 0;
+    expect(map.replace(5, 50, 0, &old) && old == 5 && !map.replace(0, 1, 0) && !map.insert(5, 0, 0),
+           "replace only present keys; insert only new ones");
+}
+
+static void testStringSet() {
+    std::cout << "StringSet" << std::endl;
+    // Keys share long prefixes, so most comparisons read the tails
+    auto name = [](int i) { return "shared-prefix/" + std::to_string(i); };
+    StringSet set;
+    runThreads([&](int id) {
+        for (int i = id; i < 4000; i += TEST_THREADS) {
+            expect(set.insert(name(i), id), "insert a new string");
+        }
+        for (int i = id; i < 4000; i += 2 * TEST_THREADS) {
+            expect(set.remove(name(i), id), "remove a present string");
+        }
+    });
+    bool exact = true;
+    for (int i = 0; i < 4000; ++i) {
+        exact = exact && set.contains(name(i), 0) == (i % (2 * TEST_THREADS) >= TEST_THREADS);
+    }
+    expect(exact && set.get_length() == 2000 && set.checkList(), "string set holds the remaining keys");
+
+    // Short keys tie on their zero-padded prefixes and order by size
+    StringSet shortKeys;
+    std::string withZero("ab\0", 3);
+    expect(shortKeys.insert("ab", 0) && shortKeys.insert(withZero, 0) && shortKeys.insert("", 0) &&
+           !shortKeys.insert(std::string_view("ab"), 0), "short keys are distinct by size");
+    expect(shortKeys.contains(withZero, 0) && shortKeys.remove("ab", 0) && shortKeys.contains(withZero, 0) &&
+           shortKeys.checkList(), "zero-padded prefixes compare by size");
+}
+
+// Append a request frame whose payload is 'words', 32 bits each
+static void putFrame(std::vector<uint8_t>& out, uint8_t op, uint32_t id, const std::vector<uint32_t>& words) {
+    size_t start = out.size();
+    out.resize(start + PROTOCOL_HEADER_SIZE + 4 * words.size());
+    uint8_t* frame = out.data() + start;
+    putFixed(frame, 4 * words.size(), 4);
+    putFixed(frame + 4, id, 4);
+    frame[8] = op;
+    frame[9] = frame[10] = frame[11] = 0;
+    for (size_t i = 0; i < words.size(); ++i) {
+        putFixed(frame + PROTOCOL_HEADER_SIZE + 4 * i, words[i], 4);
+    }
+}
+
+// Connect to the server at 'path', retrying while it starts up; -1 if it never does
+static int connectServer(const std::string& path) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    path.copy(addr.sun_path, sizeof(addr.sun_path) - 1);
+    for (int attempt = 0; attempt < 100; ++attempt) {
+        int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (connect(fd, (sockaddr*)&addr, sizeof(addr)) == 0) {
+            timeval timeout{10, 0}; // A server that stops answering fails the test instead of hanging it
+            setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+            return fd;
+        }
+        ::close(fd);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    return -1;
+}
+
+// Runs ./server, which `make test` builds first
+static void testListServer() {
+    std::cout << "List server" << std::endl;
+    std::string dir = tempDir();
+    std::string path = dir + "/sock";
+    pid_t server = fork();
+    if (server == 0) {
+        int null = open("/dev/null", O_WRONLY);
+        dup2(null, STDOUT_FILENO);
+        execl("./server", "./server", path.c_str(), "2", (char*)nullptr);
+        _exit(127);
+    }
+    int fd = connectServer(path);
+    expect(fd >= 0, "server accepts connections");
+    if (fd < 0) {
+        kill(server, SIGKILL);
+        waitpid(server, nullptr, 0);
+        removeDir(dir);
+        return;
+    }
+
+    // One pipelined batch of mixed and malformed requests, then enough full
+    // pages to push the server past SERVER_MAX_BACKLOG before any is read
+    const uint32_t total = PROTOCOL_MAX_RANGE + 5000;
+    const int pages = 64;
+    std::vector<uint32_t> keys;
+    for (uint32_t key = 0; key < total; ++key) {
+        keys.push_back(key);
+    }
+    std::vector<uint8_t> requests;
+    keys.insert(keys.begin(), total);
+    putFrame(requests, OP_INSERT, 1, keys);
+    putFrame(requests, OP_CONTAINS, 2, {5, 5, 6, (uint32_t)-1, total - 1, total});
+    putFrame(requests, OP_INSERT, 3, {3, 7, 8}); // Count says 3 keys, 2 follow
+    putFrame(requests, OP_REMOVE, 4, {3, 5, 6, total});
+    putFrame(requests, 99, 5, {});
+    putFrame(requests, OP_LENGTH, 6, {});
+    putFrame(requests, OP_RANGE, 7, {0, INT_MAX, UINT32_MAX});
+    putFrame(requests, OP_RANGE, 8, {PROTOCOL_MAX_RANGE + 2, INT_MAX, 10});
+    putFrame(requests, OP_RANGE, 9, {0, INT_MAX}); // No limit
+    for (int page = 0; page < pages; ++page) {
+        putFrame(requests, OP_RANGE, 100 + page, {0, INT_MAX, UINT32_MAX});
+    }
+    bool sent = true;
+    for (size_t pos = 0; sent && pos < requests.size();) {
+        ssize_t n = ::write(fd, requests.data() + pos, requests.size() - pos);
+        sent = n > 0;
+        pos += std::max<ssize_t>(n, 0);
+    }
+    shutdown(fd, SHUT_WR); // The server closes once every response is out
+
+    std::vector<uint8_t> responses;
+    uint8_t chunk[64 * 1024];
+    ssize_t n;
+    while ((n = ::read(fd, chunk, sizeof(chunk))) > 0) {
+        responses.insert(responses.end(), chunk, chunk + n);
+    }
+    expect(sent && n == 0, "server answers the whole pipeline and closes");
+    ::close(fd);
+
+    // Each response as (id, status, payload words); result bytes are
+    // checked in the raw payload
+    struct Response {
+        uint32_t id;
+        uint8_t status;
+        std::vector<uint8_t> payload;
+        uint32_t word(size_t i) const { return (uint32_t)getFixed(payload.data() + 4 * i, 4); }
+    };
+    std::vector<Response> got;
+    for (size_t pos = 0; responses.size() - pos >= PROTOCOL_HEADER_SIZE;) {
+        const uint8_t* frame = responses.data() + pos;
+        size_t len = getFixed(frame, 4);
+        if (responses.size() - pos - PROTOCOL_HEADER_SIZE < len) {
+            break;
+        }
+        got.push_back(Response{(uint32_t)getFixed(frame + 4, 4), frame[8],
+                               std::vector<uint8_t>(frame + PROTOCOL_HEADER_SIZE, frame + PROTOCOL_HEADER_SIZE + len)});
+        pos += PROTOCOL_HEADER_SIZE + len;
+    }
+    std::vector<uint32_t> ids;
+    for (const Response& r : got) {
+        ids.push_back(r.id);
+    }
+    std::vector<uint32_t> order = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+    for (int page = 0; page < pages; ++page) {
+        order.push_back(100 + page);
+    }
+    expect(ids == order, "responses come back in request order");
+    if (ids == order) {
+        const uint8_t contains[] = {1, 1, 0, 1, 0};
+        const uint8_t removed[] = {1, 1, 0};
+        expect(got[0].status == STATUS_OK && got[0].word(0) == total, "insert response");
+        expect(got[1].payload.size() == 9 && got[1].word(0) == 5 &&
+               std::equal(contains, contains + 5, got[1].payload.begin() + 4), "contains results");
+        expect(got[2].status == STATUS_BAD_REQUEST && got[2].payload.empty(), "short insert is a bad request");
+        expect(got[3].payload.size() == 7 && std::equal(removed, removed + 3, got[3].payload.begin() + 4),
+               "remove results");
+        expect(got[4].status == STATUS_BAD_REQUEST && got[4].payload.empty(), "unknown opcode is a bad request");
+        expect(got[5].word(0) == total - 2, "length after removes");
+
+        // The first page stops at PROTOCOL_MAX_RANGE keys, and the next
+        // one starts after its last key
+        bool paged = got[6].word(0) == PROTOCOL_MAX_RANGE && got[6].word(5) == 4 && got[6].word(6) == 7 &&
+                     got[6].word(PROTOCOL_MAX_RANGE) == PROTOCOL_MAX_RANGE + 1 && got[7].word(0) == 10;
+        for (uint32_t i = 0; i < 10; ++i) {
+            paged = paged && got[7].word(1 + i) == PROTOCOL_MAX_RANGE + 2 + i;
+        }
+        expect(paged, "range pages at PROTOCOL_MAX_RANGE");
+        expect(got[8].status == STATUS_BAD_REQUEST && got[8].payload.empty(), "range without a limit is a bad request");
+        bool full = true;
+        for (int page = 0; page < pages; ++page) {
+            full = full && got[9 + page].payload == got[6].payload;
+        }
+        expect(full, "pages held back by the backlog are answered in full");
+    }
+
+    // A frame over PROTOCOL_MAX_PAYLOAD closes its connection at once
+    fd = connectServer(path);
+    std::vector<uint8_t> oversized;
+    putFrame(oversized, OP_LENGTH, 1, {});
+    putFixed(oversized.data(), PROTOCOL_MAX_PAYLOAD + 1, 4);
+    bool closed = fd >= 0 && ::write(fd, oversized.data(), oversized.size()) == (ssize_t)oversized.size() &&
+                  ::read(fd, chunk, sizeof(chunk)) == 0;
+    expect(closed, "oversized frame closes the connection");
+    ::close(fd);
+
+    int status = 0;
+    kill(server, SIGTERM);
+    waitpid(server, &status, 0);
+    expect(WIFEXITED(status) && WEXITSTATUS(status) == 0, "server shuts down cleanly");
+    removeDir(dir);
+}
+
+int main() {
+    testBoundedList();
+    testRangeList();
+    testHybridSet();
+    testLsmSet();
+    testBLinkTree();
+    testSnapshot();
+    testPersistentList();
+    testDurableList();
+    testSharedList();
+    testReplicatedList();
+    testChangeFeed();
+    testParallelBuild();
+    testParallelReduce();
+    testSetAlgebra();
+    testSplitSplice();
+    testRemoveIf();
+    testApplyBatch();
+    testAsyncList();
+    testCursor();
+    testWaitFor();
+    testMove();
+    testMarkedMap();
+    testStringSet();
+    testListServer();
+
+    if (failures == 0) {
+        std::cout << "ALL TESTS PASSED" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
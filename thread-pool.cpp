@@ -0,0 +1,121 @@
+#include "thread-pool.hpp"
+
+#include <algorithm>
+
+static uint64_t packBounds(uint32_t next, uint32_t end) {
+    return ((uint64_t)next << 32) | end;
+}
+
+ThreadPool::ThreadPool(int numThreads) : task(nullptr), busy(0), generation(0), stopping(false) {
+    if (numThreads <= 0) {
+        numThreads = (int)std::max(1u, std::thread::hardware_concurrency());
+    }
+    blocks.reset(new Block[numThreads]);
+    for (int i = 0; i < numThreads; ++i) {
+        blocks[i].bounds.store(0);
+    }
+    for (int i = 1; i < numThreads; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+int ThreadPool::size() {
+    return (int)workers.size() + 1;
+}
+
+// Move the back half of the largest other block into this thread's empty
+// block; false once every block is empty
+bool ThreadPool::steal(int thread) {
+    while (true) {
+        int victim = -1;
+        uint64_t seen = 0;
+        uint32_t most = 0;
+        for (int i = 0; i < size(); ++i) {
+            uint64_t bounds = blocks[i].bounds.load();
+            uint32_t next = (uint32_t)(bounds >> 32);
+            uint32_t end = (uint32_t)bounds;
+            if (i != thread && next < end && end - next > most) {
+                victim = i;
+                seen = bounds;
+                most = end - next;
+            }
+        }
+        if (victim < 0) {
+            return false;
+        }
+        uint32_t next = (uint32_t)(seen >> 32);
+        uint32_t end = (uint32_t)seen;
+        uint32_t split = end - std::max<uint32_t>(1, most / 2);
+        if (blocks[victim].bounds.compare_exchange_strong(seen, packBounds(next, split))) {
+            blocks[thread].bounds.store(packBounds(split, end));
+            return true;
+        }
+    }
+}
+
+void ThreadPool::drain(int thread) {
+    Block& own = blocks[thread];
+    do {
+        uint64_t bounds = own.bounds.load();
+        while ((uint32_t)(bounds >> 32) < (uint32_t)bounds) {
+            uint32_t next = (uint32_t)(bounds >> 32);
+            if (own.bounds.compare_exchange_weak(bounds, packBounds(next + 1, (uint32_t)bounds))) {
+                (*task)((int)next, thread);
+                bounds = own.bounds.load();
+            }
+        }
+    } while (steal(thread));
+}
+
+void ThreadPool::workerLoop(int thread) {
+    uint64_t seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+        }
+        drain(thread);
+        {
+            std::lock_guard<std::mutex> lock(m);
+            if (--busy == 0) {
+                finished.notify_one();
+            }
+        }
+    }
+}
+
+void ThreadPool::parallelFor(int count, const std::function<void(int, int)>& task) {
+    std::lock_guard<std::mutex> run(runMutex);
+    {
+        std::lock_guard<std::mutex> lock(m);
+        this->task = &task;
+        int threads = size();
+        for (int i = 0; i < threads; ++i) {
+            uint32_t begin = (uint32_t)((int64_t)count * i / threads);
+            uint32_t end = (uint32_t)((int64_t)count * (i + 1) / threads);
+            blocks[i].bounds.store(packBounds(begin, end));
+        }
+        busy = (int)workers.size();
+        generation++;
+    }
+    wake.notify_all();
+    drain(0);
+
+    std::unique_lock<std::mutex> lock(m);
+    finished.wait(lock, [&] { return busy == 0; });
+}
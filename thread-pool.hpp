@@ -0,0 +1,55 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstdint>
+
+// ------------------------------------------------------
+// Thread Pool
+// ------------------------------------------------------
+// A fixed set of worker threads for data-parallel loops. parallelFor gives
+// every thread, the caller included, a contiguous block of task indices. A
+// thread that finishes its block steals the back half of the largest block
+// it finds, so neighbouring tasks mostly run on one thread and uneven
+// tasks still balance. One loop runs at a time; concurrent callers take
+// turns.
+class ThreadPool {
+public:
+    explicit ThreadPool(int numThreads = 0); // Counting the caller; 0 for one per core
+    ~ThreadPool();
+
+    int size(); // Threads that run a loop, including the caller
+
+    // Run task(i, thread) for i in [0, count); 'thread' is 0 for the caller
+    // and 1 .. size() - 1 for the workers
+    void parallelFor(int count, const std::function<void(int, int)>& task);
+
+private:
+    struct alignas(64) Block {
+        std::atomic<uint64_t> bounds; // Next task in the high half, end in the low half
+    };
+
+    std::vector<std::thread> workers;
+    std::unique_ptr<Block[]> blocks; // One per thread
+    std::mutex m;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    std::mutex runMutex; // Serializes parallelFor calls
+
+    const std::function<void(int, int)>* task;
+    int busy;            // Workers still in the current loop
+    uint64_t generation; // Bumped for every loop
+    bool stopping;
+
+    void workerLoop(int thread);
+    void drain(int thread);
+    bool steal(int thread);
+};
+
+#endif
@@ -0,0 +1,51 @@
+#include "wait-table.hpp"
+
+#include <climits>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+WaitTable::WaitTable() {
+    for (Bucket& bucket : buckets) {
+        bucket.epoch.store(0);
+        bucket.waiters.store(0);
+    }
+}
+
+WaitTable::Bucket& WaitTable::bucketOf(int key) {
+    uint32_t hash = (uint32_t)key * 0x9E3779B1u; // Fibonacci hashing spreads runs of keys
+    return buckets[(hash >> 24) % WAIT_TABLE_BUCKETS];
+}
+
+void WaitTable::wakeBucket(Bucket& bucket) {
+    if (bucket.waiters.load() == 0) {
+        return;
+    }
+    bucket.epoch.fetch_add(1);
+    syscall(SYS_futex, &bucket.epoch, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+}
+
+void WaitTable::wake(int key) {
+    wakeBucket(bucketOf(key));
+}
+
+void WaitTable::wakeAll() {
+    for (Bucket& bucket : buckets) {
+        wakeBucket(bucket);
+    }
+}
+
+bool WaitTable::sleep(Bucket& bucket, uint32_t epoch, std::chrono::steady_clock::time_point deadline) {
+    auto left = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - std::chrono::steady_clock::now());
+    if (left.count() <= 0) {
+        return false;
+    }
+    struct timespec timeout;
+    timeout.tv_sec = left.count() / 1000000000;
+    timeout.tv_nsec = left.count() % 1000000000;
+    // Returns at once if the epoch has moved on; spurious returns just
+    // make the caller check again
+    syscall(SYS_futex, &bucket.epoch, FUTEX_WAIT_PRIVATE, epoch, &timeout, nullptr, 0);
+    return true;
+}
@@ -0,0 +1,61 @@
+#ifndef WAIT_TABLE_H
+#define WAIT_TABLE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#define WAIT_TABLE_BUCKETS 256 // Futex words per table; keys that share one wake each other
+
+// ------------------------------------------------------
+// Wait Table
+// ------------------------------------------------------
+// Threads waiting for a key sleep on the futex word of the key's hashed
+// bucket. Each bucket counts its waiters, so waking a bucket nobody waits
+// on costs one load and no system call. A waker bumps the bucket's epoch
+// before the futex wake, and a waiter sleeps only while the epoch is the
+// one it read before checking its condition, so no wake-up is lost.
+// Keys that share a bucket wake each other, and their waiters check again.
+class WaitTable {
+public:
+    WaitTable();
+
+    // Block until 'ready()' returns true or 'deadline' passes; returns the
+    // last result of 'ready()'. The thread that makes it true must call
+    // wake(key) afterwards.
+    template <typename F>
+    bool waitUntil(int key, std::chrono::steady_clock::time_point deadline, F ready) {
+        Bucket& bucket = bucketOf(key);
+        bucket.waiters.fetch_add(1);
+        bool done;
+        while (true) {
+            uint32_t epoch = bucket.epoch.load();
+            if ((done = ready()) || !sleep(bucket, epoch, deadline)) {
+                break;
+            }
+        }
+        if (!done) {
+            done = ready();
+        }
+        bucket.waiters.fetch_sub(1);
+        return done;
+    }
+
+    void wake(int key); // Wake the waiters in key's bucket
+    void wakeAll();
+
+private:
+    struct alignas(64) Bucket {
+        std::atomic<uint32_t> epoch; // The futex word
+        std::atomic<int> waiters;
+    };
+
+    Bucket buckets[WAIT_TABLE_BUCKETS];
+
+    Bucket& bucketOf(int key);
+    void wakeBucket(Bucket& bucket);
+    // Sleep while the epoch is still 'epoch'; false once 'deadline' has passed
+    static bool sleep(Bucket& bucket, uint32_t epoch, std::chrono::steady_clock::time_point deadline);
+};
+
+#endif
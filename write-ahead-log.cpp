@@ -0,0 +1,312 @@
+#include "write-ahead-log.hpp"
+#include "serialization.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+WriteAheadLog::WriteAheadLog()
+    : fd(-1), nextLsn(1), durable(0), waiters(0), stopping(false), failed(false),
+      rotateFd(-1), rotated(false) {}
+
+WriteAheadLog::~WriteAheadLog() {
+    close();
+}
+
+// Read every intact batch; 'validLength' ends at the last one
+bool WriteAheadLog::readLog(int fd, std::vector<Record>& records, off_t& validLength) {
+    validLength = 0;
+    if (lseek(fd, 0, SEEK_SET) != 0) {
+        return false;
+    }
+    std::vector<uint8_t> payload;
+    while (true) {
+        uint8_t header[12];
+        if (!readAll(fd, header, sizeof(header))) {
+            return true;
+        }
+        uint32_t magic = (uint32_t)getFixed(header, 4);
+        uint32_t len = (uint32_t)getFixed(header + 4, 4);
+        uint32_t crc = (uint32_t)getFixed(header + 8, 4);
+        if (magic != WAL_BATCH_MAGIC || len % WAL_RECORD_SIZE != 0) {
+            return true;
+        }
+        payload.resize(len);
+        if (!readAll(fd, payload.data(), len) || crc32(payload.data(), len) != crc) {
+            return true;
+        }
+        for (size_t pos = 0; pos < len; pos += WAL_RECORD_SIZE) {
+            const uint8_t* in = payload.data() + pos;
+            Record record;
+            record.lsn = getFixed(in, 8);
+            record.key = (int)(uint32_t)getFixed(in + 8, 4);
+            record.op = (Op)in[12];
+            records.push_back(record);
+        }
+        validLength += sizeof(header) + len;
+    }
+}
+
+bool WriteAheadLog::read(const std::string& path, std::vector<Record>& records) {
+    int in = ::open(path.c_str(), O_RDONLY);
+    if (in < 0) {
+        return false;
+    }
+    off_t validLength;
+    bool ok = readLog(in, records, validLength);
+    ::close(in);
+    return ok;
+}
+
+bool WriteAheadLog::open(const std::string& path, std::vector<Record>* existing,
+                         uint64_t lastLsn) {
+    if (fd >= 0) {
+        return false;
+    }
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        return false;
+    }
+
+    std::vector<Record> records;
+    off_t validLength;
+    if (!readLog(fd, records, validLength) || ftruncate(fd, validLength) != 0 ||
+        lseek(fd, validLength, SEEK_SET) != validLength) {
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+
+    uint64_t last = lastLsn;
+    for (const Record& record : records) {
+        last = std::max(last, record.lsn);
+    }
+    nextLsn.store(last + 1);
+    durable = last;
+    stopping = false;
+    failed = false;
+    if (existing) {
+        existing->swap(records);
+    }
+
+    writer = std::thread(&WriteAheadLog::writerLoop, this);
+    return true;
+}
+
+bool WriteAheadLog::rotate(const std::string& newPath) {
+    int next = ::open(newPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (next < 0) {
+        return false;
+    }
+    std::unique_lock<std::mutex> lock(m);
+    if (!writer.joinable()) {
+        ::close(next);
+        return false;
+    }
+    rotateFd = next;
+    rotated = false;
+    writerCv.notify_one();
+    durableCv.wait(lock, [&] { return rotated; });
+    return true;
+}
+
+void WriteAheadLog::close() {
+    if (writer.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            stopping = true;
+        }
+        writerCv.notify_one();
+        writer.join();
+    }
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+uint64_t WriteAheadLog::append(int threadID, Op op, int key) {
+    // The LSN is taken under the buffer lock, so once the writer has read
+    // 'nextLsn' every smaller LSN is already in a buffer it will drain
+    ThreadBuffer& buffer = buffers[threadID];
+    std::lock_guard<std::mutex> lock(buffer.m);
+    uint64_t lsn = nextLsn.fetch_add(1);
+    buffer.records.push_back({lsn, key, op});
+    return lsn;
+}
+
+bool WriteAheadLog::waitDurable(uint64_t lsn) {
+    std::unique_lock<std::mutex> lock(m);
+    if (durable >= lsn || failed) {
+        return durable >= lsn;
+    }
+    waiters++;
+    writerCv.notify_one();
+    durableCv.wait(lock, [&] { return durable >= lsn || failed; });
+    waiters--;
+    return durable >= lsn;
+}
+
+uint64_t WriteAheadLog::durableLsn() {
+    std::lock_guard<std::mutex> lock(m);
+    return durable;
+}
+
+uint64_t WriteAheadLog::lastLsn() {
+    return nextLsn.load() - 1;
+}
+
+bool WriteAheadLog::writeBatch(int target, std::vector<Record>& batch) {
+    std::vector<uint8_t> bytes(12 + batch.size() * WAL_RECORD_SIZE);
+    uint8_t* out = bytes.data() + 12;
+    for (const Record& record : batch) {
+        putFixed(out, record.lsn, 8);
+        putFixed(out + 8, (uint32_t)record.key, 4);
+        out[12] = (uint8_t)record.op;
+        out += WAL_RECORD_SIZE;
+    }
+    size_t len = bytes.size() - 12;
+    putFixed(bytes.data(), WAL_BATCH_MAGIC, 4);
+    putFixed(bytes.data() + 4, len, 4);
+    putFixed(bytes.data() + 8, crc32(bytes.data() + 12, len), 4);
+    return writeAll(target, bytes.data(), bytes.size()) && fdatasync(target) == 0;
+}
+
+void WriteAheadLog::writerLoop() {
+    std::vector<Record> batch;
+    std::vector<Record> drained;
+    while (true) {
+        bool last;
+        int switchTo;
+        {
+            std::unique_lock<std::mutex> lock(m);
+            writerCv.wait_for(lock, std::chrono::microseconds(WAL_GROUP_COMMIT_US),
+                              [&] { return stopping || waiters > 0 || rotateFd >= 0; });
+            last = stopping;
+            switchTo = rotateFd;
+        }
+
+        // Every LSN below 'upTo' is in a buffer by now (see append)
+        uint64_t upTo = nextLsn.load() - 1;
+        batch.clear();
+        for (ThreadBuffer& buffer : buffers) {
+            {
+                std::lock_guard<std::mutex> lock(buffer.m);
+                drained.swap(buffer.records);
+            }
+            batch.insert(batch.end(), drained.begin(), drained.end());
+            drained.clear();
+        }
+
+        // On rotation, later batches go to the new segment while this one
+        // still completes the old segment
+        int target = fd;
+        if (switchTo >= 0) {
+            fd = switchTo;
+            {
+                std::lock_guard<std::mutex> lock(m);
+                rotateFd = -1;
+                rotated = true;
+            }
+            durableCv.notify_all();
+        }
+
+        bool ok = batch.empty() || writeBatch(target, batch);
+        if (switchTo >= 0) {
+            ok = (fdatasync(target) == 0) && ok;
+            ::close(target);
+        }
+        {
+            std::lock_guard<std::mutex> lock(m);
+            if (ok) {
+                durable = std::max(durable, upTo);
+            } else {
+                failed = true; // Waiters give up rather than block forever
+            }
+        }
+        durableCv.notify_all();
+
+        if (last) {
+            return;
+        }
+    }
+}
+
+std::vector<int> WriteAheadLog::replay(const std::vector<Record>& records, int numThreads,
+                                       const std::vector<int>& base) {
+    if (records.empty()) {
+        return base;
+    }
+    numThreads = std::max(1, numThreads);
+
+    // Split the key space into equal-width ranges, one per thread
+    long long lo = INT_MAX, hi = INT_MIN;
+    for (const Record& record : records) {
+        lo = std::min(lo, (long long)record.key);
+        hi = std::max(hi, (long long)record.key);
+    }
+    if (!base.empty()) {
+        lo = std::min(lo, (long long)base.front());
+        hi = std::max(hi, (long long)base.back());
+    }
+    long long width = (hi - lo) / numThreads + 1;
+    std::vector<std::vector<Record>> ranges(numThreads);
+    for (const Record& record : records) {
+        ranges[(record.key - lo) / width].push_back(record);
+    }
+
+    std::vector<std::vector<int>> results(numThreads);
+    auto replayRange = [&](int r) {
+        std::vector<Record>& range = ranges[r];
+        std::sort(range.begin(), range.end(), [](const Record& a, const Record& b) {
+            return a.key != b.key ? a.key < b.key : a.lsn < b.lsn;
+        });
+        long long rangeLo = lo + r * width;
+        auto b = std::lower_bound(base.begin(), base.end(), rangeLo);
+        auto bEnd = std::lower_bound(b, base.end(), rangeLo + width);
+
+        // Merge the base keys with the per-key record runs. Only removes that
+        // found the key were logged, so a count never goes below zero on a
+        // complete log.
+        std::vector<int>& out = results[r];
+        size_t i = 0;
+        while (i < range.size() || b != bEnd) {
+            if (i == range.size() || (b != bEnd && *b < range[i].key)) {
+                out.push_back(*b++);
+                continue;
+            }
+            int key = range[i].key;
+            int count = 0;
+            for (; b != bEnd && *b == key; ++b) {
+                count++;
+            }
+            for (; i < range.size() && range[i].key == key; ++i) {
+                if (range[i].op == Op::Insert) {
+                    count++;
+                } else if (count > 0) {
+                    count--;
+                }
+            }
+            out.insert(out.end(), count, key);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int r = 1; r < numThreads; ++r) {
+        threads.emplace_back(replayRange, r);
+    }
+    replayRange(0);
+    for (std::thread& t : threads) {
+        t.join();
+    }
+
+    std::vector<int> keys;
+    keys.reserve(base.size() + records.size());
+    for (std::vector<int>& result : results) {
+        keys.insert(keys.end(), result.begin(), result.end());
+    }
+    return keys;
+}
@@ -0,0 +1,94 @@
+#ifndef WRITE_AHEAD_LOG_H
+#define WRITE_AHEAD_LOG_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+
+#include "reclamation.hpp"
+
+#define WAL_BATCH_MAGIC 0x424c4157u // "WALB"
+#define WAL_RECORD_SIZE 13          // lsn (8) | key (4) | op (1)
+#define WAL_GROUP_COMMIT_US 1000    // Longest an async record waits for a batch
+
+// ------------------------------------------------------
+// Write-Ahead Log with Group Commit
+// ------------------------------------------------------
+// append() tags a record with the next log sequence number (LSN) and
+// queues it in the caller's per-thread buffer. A log writer thread drains
+// all buffers into one batch, writes it with a single write() and
+// fdatasync(), then advances the durable LSN. It wakes up every
+// WAL_GROUP_COMMIT_US, or as soon as a caller waits for durability.
+//
+// File format: a sequence of batches, each
+//   magic (4) | payload length (4) | CRC-32 of payload (4) | records
+// with little-endian fields. Records within the log are not in LSN order.
+// A torn or corrupt batch at the tail is cut off when the log is opened.
+// rotate() moves appends to a new segment file, so a checkpoint can delete
+// the segments it covers.
+class WriteAheadLog {
+public:
+    enum class Op : uint8_t { Insert = 1, Remove = 2 };
+
+    struct Record {
+        uint64_t lsn;
+        int key;
+        Op op;
+    };
+
+    WriteAheadLog();
+    ~WriteAheadLog(); // Flushes outstanding records and stops the log writer
+
+    // Open 'path' for appending, creating it if needed; the valid records
+    // already in it are returned through 'existing'. LSNs continue after
+    // both the file's records and 'lastLsn'.
+    bool open(const std::string& path, std::vector<Record>* existing = nullptr,
+              uint64_t lastLsn = 0);
+    void close();
+    // Switch appends to a new segment; records appended before the call go
+    // to the old one, which is closed once they are durable
+    bool rotate(const std::string& newPath);
+    static bool read(const std::string& path, std::vector<Record>& records);
+
+    uint64_t append(int threadID, Op op, int key); // Returns the record's LSN
+    bool waitDurable(uint64_t lsn); // Block until every record up to 'lsn' is on disk; false if the log failed
+    uint64_t durableLsn();
+    uint64_t lastLsn(); // Last LSN handed out
+
+    // Apply records in LSN order per key on top of the ascending keys in
+    // 'base', in parallel over key ranges, and return the resulting
+    // multiset of keys in ascending order
+    static std::vector<int> replay(const std::vector<Record>& records, int numThreads,
+                                   const std::vector<int>& base = {});
+
+private:
+    struct alignas(64) ThreadBuffer {
+        std::mutex m;
+        std::vector<Record> records;
+    };
+
+    int fd;
+    std::atomic<uint64_t> nextLsn;
+    ThreadBuffer buffers[MAX_THREADS];
+
+    std::thread writer;
+    std::mutex m;
+    std::condition_variable writerCv;  // Wakes the log writer
+    std::condition_variable durableCv; // Wakes callers waiting for durability
+    uint64_t durable;
+    int waiters;
+    bool stopping;
+    bool failed;
+    int rotateFd;   // Segment to switch to, or -1
+    bool rotated;
+
+    void writerLoop();
+    bool writeBatch(int target, std::vector<Record>& batch);
+    static bool readLog(int fd, std::vector<Record>& records, off_t& validLength);
+};
+
+#endif